@@ -0,0 +1,141 @@
+#include "autotune.h"
+#include "benchmark.h"
+#include "bmssp.h"
+#include "dijkstra.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace autotune {
+    namespace {
+        struct Sample {
+            Graph graph;
+            int start_node;
+            double dijkstra_ms;
+        };
+
+        struct Family {
+            std::string generator_type;
+            std::vector<Sample> samples;
+        };
+
+        int bmssp_start_node(const ExperimentConfig& exp) {
+            for (const auto& algo : exp.algorithms) {
+                if (algo.name == "bmssp") return algo.start_node;
+            }
+            return exp.algorithms.empty() ? 0 : exp.algorithms.front().start_node;
+        }
+
+        double time_query(const Graph& graph, const int start, const AutotuneConfig& tune, auto&& algorithm) {
+            const auto result = run_benchmark(graph, algorithm, tune.iterations, tune.warmup, start);
+            if (!result.success) throw std::runtime_error(result.error_msg);
+            return result.avg_time_ms;
+        }
+
+        double score_params(const Family& family, const BmsspParams& params, const AutotuneConfig& tune) {
+            double log_sum = 0.0;
+            for (const auto& sample : family.samples) {
+                bmssp<double> solver(sample.graph);
+                solver.set_params(params);
+                solver.prepare_graph(true);
+                const double ms = time_query(sample.graph, sample.start_node, tune, [&solver](int s) {
+                    return solver.query(s).dist;
+                });
+                log_sum += std::log(std::max(ms, 1e-6) / std::max(sample.dijkstra_ms, 1e-6));
+            }
+            return std::exp(log_sum / family.samples.size());
+        }
+    } // namespace
+
+    std::vector<TunedParams> tune_bmssp(const Config& config, std::ostream& out) {
+        const AutotuneConfig& tune = config.autotune;
+
+        std::vector<Family> families;
+        for (const auto& exp : config.experiments) {
+            auto it = std::find_if(families.begin(), families.end(),
+                                   [&](const Family& f) { return f.generator_type == exp.generator_type; });
+            if (it == families.end()) {
+                families.push_back({exp.generator_type, {}});
+                it = families.end() - 1;
+            }
+            const int start = bmssp_start_node(exp);
+            for (auto& graph : sample_graphs_for_experiment(exp, tune.samples)) {
+                if (start < 0 || start >= graph.size()) continue;
+                const double ms = time_query(graph, start, tune, [&graph](int s) { return dijkstra(graph, s, ""); });
+                it->samples.push_back({std::move(graph), start, ms});
+            }
+        }
+
+        std::vector<BmsspParams> candidates{BmsspParams{}};
+        for (int k : tune.k) {
+            for (int t : tune.t) {
+                for (double scale : tune.block_scale) {
+                    for (long long cutoff : tune.hybrid_cutoff) {
+                        BmsspParams p;
+                        p.k = k;
+                        p.t = t;
+                        p.block_scale = scale;
+                        p.hybrid_cutoff = cutoff;
+                        candidates.push_back(p);
+                    }
+                }
+            }
+        }
+
+        out << "Generator\tGraphs\tk\tt\tBlockScale\tHybridCutoff\tScore\n";
+        std::vector<TunedParams> tuned;
+        for (const auto& family : families) {
+            if (family.samples.empty()) continue;
+
+            TunedParams best{family.generator_type, {}, std::numeric_limits<double>::infinity(), 0.0,
+                             static_cast<int>(family.samples.size())};
+            for (size_t c = 0; c < candidates.size(); ++c) {
+                const double score = score_params(family, candidates[c], tune);
+                if (c == 0) best.default_score = score;
+                if (score < best.score) {
+                    best.score = score;
+                    best.params = candidates[c];
+                }
+
+                out << family.generator_type << "\t" << family.samples.size() << "\t";
+                if (c == 0) out << "default\tdefault\t";
+                else out << candidates[c].k << "\t" << candidates[c].t << "\t";
+                out << candidates[c].block_scale << "\t";
+                if (candidates[c].hybrid_cutoff < 0) out << "auto\t";
+                else out << candidates[c].hybrid_cutoff << "\t";
+                out << std::fixed << std::setprecision(4) << score << std::defaultfloat << "\n";
+            }
+            tuned.push_back(best);
+        }
+        return tuned;
+    }
+
+    bool save_tuned_params(const std::vector<TunedParams>& tuned, const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: could not open file " << filename << " for writing.\n";
+            return false;
+        }
+
+        file << "# bmssp settings found by --autotune; k: 0 / t: 0 mean the paper's defaults.\n"
+             << "# score = geometric mean of bmssp / dijkstra query time, below 1 bmssp is faster.\n"
+             << "tuned:\n";
+        for (const auto& t : tuned) {
+            file << "  - { generator: " << t.generator_type
+                 << ", k: " << t.params.k
+                 << ", t: " << t.params.t
+                 << ", block_scale: " << t.params.block_scale
+                 << ", hybrid_cutoff: ";
+            if (t.params.hybrid_cutoff < 0) file << "auto";
+            else file << t.params.hybrid_cutoff;
+            file << ", score: " << t.score
+                 << ", default_score: " << t.default_score
+                 << ", graphs: " << t.graphs << " }\n";
+        }
+        return true;
+    }
+} // namespace autotune
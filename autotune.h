@@ -0,0 +1,29 @@
+#ifndef SMALLCPPPROGRAM_AUTOTUNE_H
+#define SMALLCPPPROGRAM_AUTOTUNE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+namespace autotune {
+    // Best bmssp settings for one generator family. Scores are the geometric mean of
+    // bmssp / dijkstra query time over the sampled graphs, so below 1 means bmssp wins.
+    struct TunedParams {
+        std::string generator_type;
+        BmsspParams params;
+        double score;
+        double default_score; // same graphs with the paper's k, t and M
+        int graphs;
+    };
+
+    // Times every combination of config.autotune on graphs sampled from each experiment,
+    // writing one TSV row per family and combination to `out`.
+    std::vector<TunedParams> tune_bmssp(const Config& config, std::ostream& out);
+
+    // YAML whose entries can be copied into a bmssp algorithm entry of a config.
+    bool save_tuned_params(const std::vector<TunedParams>& tuned, const std::string& filename);
+} // namespace autotune
+
+#endif //SMALLCPPPROGRAM_AUTOTUNE_H
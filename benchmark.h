@@ -2,6 +2,11 @@
 #define SMALLCPPPROGRAM_BENCHMARK_H
 
 #include "graph_types.h"
+#include "benchmark_options.h"
+#include "memory_stats.h"
+#include "perf_counters.h"
+#include "sample_stats.h"
+#include <array>
 #include <chrono>
 #include <vector>
 #include <string>
@@ -11,6 +16,26 @@
 #include <iomanip>
 #include <cmath>
 #include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Lets a measured call split its own time between phases.
+ *
+ * The harness times the whole call; an algorithm that takes a QueryPhases& as its
+ * first argument reports how much of it was setup or extraction, and the remainder
+ * is counted as query.
+ */
+class QueryPhases {
+public:
+    void attribute(const Phase phase, const double ms) { ms_[static_cast<int>(phase)] += ms; }
+    [[nodiscard]] double ms(const Phase phase) const { return ms_[static_cast<int>(phase)]; }
+
+private:
+    std::array<double, kPhaseCount> ms_{};
+};
 
 struct BenchmarkResult {
     std::string algorithm_name;
@@ -20,24 +45,57 @@ struct BenchmarkResult {
     double min_time_ms;
     double max_time_ms;
     double std_dev_ms;
+    double median_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double ci_low_ms = 0.0;  // 95% bootstrap interval of the median
+    double ci_high_ms = 0.0;
+    int outliers = 0;        // samples flagged by the MAD rule, left out of the statistics if rejected
+    std::array<double, kPhaseCount> phase_ms{}; // prepare once, the others averaged per iteration
     int iterations;
     bool success;
     std::string error_msg;
+    std::vector<std::pair<std::string, double>> metrics; // algorithm-specific, per query
+    std::vector<std::pair<std::string, double>> counters; // hardware events per iteration, those the kernel granted
+    bool memory_measured = false;
+    bool has_preprocessing = false;
+    memory_stats::Usage preprocessing_memory; // filled by the caller around its own setup
+    memory_stats::Usage query_memory;         // allocations per iteration; peaks are the largest of any iteration
+    std::vector<double> samples_ms;           // headline time of every measured iteration, in run order
+    std::vector<int> sample_sources;          // source of each sample, when run over a source set
+    int sources = 1;
+    double qps = 0.0;                         // queries per second of headline time
 };
 
+// Samples the summary statistics are computed from.
+inline std::vector<double> kept_samples(const std::vector<double>& samples, const bool reject_outliers,
+                                        const int sample_groups = 1) {
+    if (!reject_outliers) return samples;
+    const std::vector<bool> outlier = sample_stats::mad_outliers_per_group(samples, static_cast<size_t>(std::max(1, sample_groups)));
+    std::vector<double> kept;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!outlier[i]) kept.push_back(samples[i]);
+    }
+    return kept;
+}
+
 /**
  * @brief Универсальный бенчмарк.
  *
  * Теперь он принимает переменное количество аргументов для алгоритма (Args... args).
  * Это позволяет передавать лямбды с любым количеством параметров.
+ * Счётчики и учёт памяти из options включаются только вокруг замеряемых итераций;
+ * в result попадают средние значения за итерацию (для пиков памяти - максимум).
+ * iterations - минимум замеров; в адаптивном режиме их может быть больше.
  */
 template <typename AlgoFunc, typename... Args>
-BenchmarkResult run_benchmark(
+BenchmarkResult run_benchmark_with(
     const Graph& graph,
     AlgoFunc algorithm,
     int iterations,
     int warmup_runs,
-    Args&&... args // Аргументы, которые будут переданы в алгоритм (например, start_node)
+    const BenchmarkOptions& options,
+    Args&&... args
 ) {
     BenchmarkResult result;
     result.vertices = graph.size();
@@ -51,14 +109,21 @@ BenchmarkResult run_benchmark(
     result.edges = static_cast<int>(edge_count);
 
     std::vector<double> times_ms;
-    times_ms.reserve(iterations);
+    times_ms.reserve(std::max(iterations, 0));
 
     using namespace std::chrono;
 
     // Лямбда-обертка для выполнения одного прогона
+    QueryPhases phases;
     auto run_once = [&]() -> auto {
-        return std::invoke(algorithm, std::forward<Args>(args)...);
+        phases = QueryPhases{};
+        if constexpr (std::is_invocable_v<AlgoFunc&, QueryPhases&, Args...>) {
+            return std::invoke(algorithm, phases, std::forward<Args>(args)...);
+        } else {
+            return std::invoke(algorithm, std::forward<Args>(args)...);
+        }
     };
+    std::array<double, kPhaseCount> phase_sum{};
 
     // --- Warmup ---
     for (int i = 0; i < warmup_runs; ++i) {
@@ -75,8 +140,35 @@ BenchmarkResult run_benchmark(
         } catch (...) {}
     }
 
+    perf::CounterGroup* counters = options.counters;
+    const bool counting = counters && counters->available();
+    long long alloc_sum = 0, alloc_bytes_sum = 0;
+    std::array<double, perf::EventCount> counter_sum{};
+    std::array<int, perf::EventCount> counter_runs{};
+
+    const AdaptiveStop& stop = options.adaptive;
+    const bool adaptive = stop.target_ci > 0 || stop.time_budget_ms > 0;
+    const int max_iterations = adaptive ? std::max(iterations, stop.max_iterations) : iterations;
+    const auto measure_start = steady_clock::now();
+    int next_ci_check = iterations;
+
     // --- Measurement ---
-    for (int i = 0; i < iterations; ++i) {
+    for (int i = 0; i < max_iterations; ++i) {
+        if (adaptive && i >= iterations) {
+            const duration<double, std::milli> spent = steady_clock::now() - measure_start;
+            if (stop.time_budget_ms > 0 && spent.count() >= stop.time_budget_ms) break;
+            // the bootstrap costs far more than a fast query, so it runs every ~10% more samples
+            if (stop.target_ci > 0 && i >= next_ci_check && i >= 5) {
+                const auto kept = kept_samples(times_ms, options.reject_outliers, options.sample_groups);
+                const auto [lo, hi] = sample_stats::bootstrap_median_ci(kept);
+                const double med = sample_stats::median(kept);
+                if (med > 0 && (hi - lo) / med <= stop.target_ci) break;
+                next_ci_check = i + std::max(1, i / 10);
+            }
+        }
+        std::optional<memory_stats::Scope> memory;
+        if (options.memory) memory.emplace();
+        if (counting) counters->start();
         auto t_start = high_resolution_clock::now();
         try {
             auto res = run_once();
@@ -101,8 +193,32 @@ BenchmarkResult run_benchmark(
         }
 
         auto t_end = high_resolution_clock::now();
+        if (counting) {
+            const perf::Sample sample = counters->stop();
+            for (int e = 0; e < perf::EventCount; ++e) {
+                if (!sample.valid[e]) continue;
+                counter_sum[e] += sample.value[e];
+                counter_runs[e]++;
+            }
+        }
+        if (memory) {
+            const memory_stats::Usage usage = memory->finish();
+            alloc_sum += usage.allocations;
+            alloc_bytes_sum += usage.bytes;
+            auto& q = result.query_memory;
+            q.peak_live_bytes = std::max(q.peak_live_bytes, usage.peak_live_bytes);
+            q.peak_rss_kb = std::max(q.peak_rss_kb, usage.peak_rss_kb);
+        }
         duration<double, std::milli> elapsed = t_end - t_start;
-        times_ms.push_back(elapsed.count());
+        const double setup_ms = phases.ms(Phase::Setup), extract_ms = phases.ms(Phase::Extract);
+        const double split[kPhaseCount] = {
+            options.prepare_ms, setup_ms, std::max(0.0, elapsed.count() - setup_ms - extract_ms), extract_ms};
+        double sample = 0.0;
+        for (int p = 0; p < kPhaseCount; ++p) {
+            if (p != static_cast<int>(Phase::Prepare)) phase_sum[p] += split[p];
+            if (options.headline[p]) sample += split[p];
+        }
+        times_ms.push_back(sample);
     }
 
     if (!result.success || times_ms.empty()) {
@@ -114,22 +230,100 @@ BenchmarkResult run_benchmark(
     }
 
     result.iterations = static_cast<int>(times_ms.size());
-    std::sort(times_ms.begin(), times_ms.end());
+    result.samples_ms = times_ms;
+    const double total_ms = std::accumulate(times_ms.begin(), times_ms.end(), 0.0);
+    if (total_ms > 0) result.qps = 1000.0 * result.iterations / total_ms;
+    result.phase_ms[static_cast<int>(Phase::Prepare)] = options.prepare_ms;
+    for (int p = 1; p < kPhaseCount; ++p) result.phase_ms[p] = phase_sum[p] / result.iterations;
+
+    const std::vector<bool> outlier = sample_stats::mad_outliers_per_group(times_ms, static_cast<size_t>(std::max(1, options.sample_groups)));
+    result.outliers = static_cast<int>(std::count(outlier.begin(), outlier.end(), true));
+    std::vector<double> kept = kept_samples(times_ms, options.reject_outliers, options.sample_groups);
+    std::tie(result.ci_low_ms, result.ci_high_ms) = sample_stats::bootstrap_median_ci(kept);
+    std::sort(kept.begin(), kept.end());
 
-    double sum = std::accumulate(times_ms.begin(), times_ms.end(), 0.0);
-    result.avg_time_ms = sum / times_ms.size();
-    result.min_time_ms = times_ms.front();
-    result.max_time_ms = times_ms.back();
+    double sum = std::accumulate(kept.begin(), kept.end(), 0.0);
+    result.avg_time_ms = sum / kept.size();
+    result.min_time_ms = kept.front();
+    result.max_time_ms = kept.back();
+    result.median_ms = sample_stats::quantile(kept, 0.5);
+    result.p90_ms = sample_stats::quantile(kept, 0.9);
+    result.p99_ms = sample_stats::quantile(kept, 0.99);
 
     double sq_sum = 0.0;
-    for (double t : times_ms) {
+    for (double t : kept) {
         sq_sum += (t - result.avg_time_ms) * (t - result.avg_time_ms);
     }
-    result.std_dev_ms = std::sqrt(sq_sum / times_ms.size());
+    result.std_dev_ms = std::sqrt(sq_sum / kept.size());
+
+    if (options.memory) {
+        result.memory_measured = true;
+        result.query_memory.allocations = alloc_sum / result.iterations;
+        result.query_memory.bytes = alloc_bytes_sum / result.iterations;
+    }
+
+    for (int e = 0; e < perf::EventCount; ++e) {
+        if (counter_runs[e] > 0) result.counters.emplace_back(perf::event_name(e), counter_sum[e] / counter_runs[e]);
+    }
 
     return result;
 }
 
+/**
+ * @brief Бенчмарк по набору источников.
+ *
+ * Итерация i запускает algorithm(sources[i % sources.size()]), так что каждый источник
+ * получает iterations замеров и warmup прогревов, а выборка - распределение задержек
+ * по всем источникам. Алгоритм может принимать QueryPhases& первым аргументом.
+ */
+template <typename AlgoFunc>
+BenchmarkResult run_benchmark_sources(
+    const Graph& graph,
+    AlgoFunc algorithm,
+    int iterations,
+    int warmup_runs,
+    const BenchmarkOptions& options,
+    const std::vector<int>& sources
+) {
+    if (sources.empty()) {
+        BenchmarkResult result;
+        result.success = false;
+        result.error_msg = "No sources";
+        return result;
+    }
+    size_t next = 0;
+    auto each = [&](QueryPhases& phases) {
+        const int s = sources[next++ % sources.size()];
+        if constexpr (std::is_invocable_v<AlgoFunc&, QueryPhases&, int>) {
+            return std::invoke(algorithm, phases, s);
+        } else {
+            return std::invoke(algorithm, s);
+        }
+    };
+    const int count = static_cast<int>(sources.size());
+    BenchmarkOptions per_source = options;
+    per_source.sample_groups = count;
+    BenchmarkResult result = run_benchmark_with(graph, each, iterations * count, warmup_runs * count, per_source);
+    // warmup is a whole number of rounds, so measured run i used sources[i % count]
+    result.sources = count;
+    result.sample_sources.resize(result.samples_ms.size());
+    for (size_t i = 0; i < result.sample_sources.size(); ++i) result.sample_sources[i] = sources[i % count];
+    return result;
+}
+
+// То же без счётчиков и учёта памяти.
+template <typename AlgoFunc, typename... Args>
+BenchmarkResult run_benchmark(
+    const Graph& graph,
+    AlgoFunc algorithm,
+    int iterations,
+    int warmup_runs,
+    Args&&... args // Аргументы, которые будут переданы в алгоритм (например, start_node)
+) {
+    return run_benchmark_with(graph, std::move(algorithm), iterations, warmup_runs, BenchmarkOptions{},
+                              std::forward<Args>(args)...);
+}
+
 inline void print_benchmark_report(const std::vector<BenchmarkResult>& results) {
     if (results.empty()) return;
     size_t max_name_len = 0;
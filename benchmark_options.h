@@ -0,0 +1,42 @@
+#ifndef SMALLCPPPROGRAM_BENCHMARK_OPTIONS_H
+#define SMALLCPPPROGRAM_BENCHMARK_OPTIONS_H
+
+#include <array>
+
+namespace perf {
+class CounterGroup;
+}
+
+// Where a query's time goes. Prepare is one-time work per graph (index builds, graph
+// transforms), the rest is per query: setup before the search, the search itself and
+// turning its state into the returned answer.
+enum class Phase { Prepare, Setup, Query, Extract };
+constexpr int kPhaseCount = 4;
+
+inline const char* phase_name(const Phase phase) {
+    static const char* const names[kPhaseCount] = {"prepare", "setup", "query", "extract"};
+    return names[static_cast<int>(phase)];
+}
+
+// Adaptive mode: after the fixed iterations, keep measuring until the 95% interval of
+// the median is narrower than target_ci * median or time_budget_ms has been spent.
+struct AdaptiveStop {
+    double target_ci = 0.0;      // relative width, 0 = no target
+    double time_budget_ms = 0.0; // wall time of the whole measurement, 0 = no budget
+    int max_iterations = 1000;
+};
+
+// Optional behaviour of run_benchmark_with.
+struct BenchmarkOptions {
+    perf::CounterGroup* counters = nullptr; // nullptr or an unavailable group: no counters
+    bool memory = false;                    // heap and RSS accounting, see memory_stats.h
+    bool reject_outliers = false;           // drop MAD outliers before computing the statistics
+    AdaptiveStop adaptive;
+    // phases summed into each sample, and so into every headline statistic; with
+    // Prepare included a sample is the cost of a one-off query on a fresh graph
+    std::array<bool, kPhaseCount> headline{false, true, true, true};
+    double prepare_ms = 0.0; // measured by the caller, which owns the preparation
+    int sample_groups = 1;   // sample i comes from source i % sample_groups; outliers are judged per source
+};
+
+#endif
@@ -3,170 +3,156 @@
 
 #include <vector>
 #include <queue>
-#include <set>
-#include <map>
-#include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <memory>
 #include <functional>
-#include <list>
+#include <fstream>
+#include <chrono>
+#include <iostream>
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <span>
 
 #include "graph_types.h"
+#include "bmssp_params.h"
+#include "parallel.h"
+#include "selection.h"
 
 constexpr double INF = std::numeric_limits<double>::infinity();
 
 constexpr double EPS = 1e-9;
 
-enum floyd_rivest_constants {
-  kQCap = 600,
-};
+// Unique distances: Assumption 2.1. A path is ordered by (length, hops, endpoint,
+// predecessor). The length is stored as an order-preserving integer image, and hops and
+// endpoint share one word. A comparison is then at most three integer compares, and the
+// first one nearly always settles it.
+template<typename wT>
+struct PackedDist {
+    static constexpr double SCALE = 1e10;
+    static constexpr double SCALE_INV = 1.0 / SCALE;
+
+    uint64_t dist = 0;
+    uint64_t hops_vertex = 0; // hops << 32 | vertex
+    int pred = 0;
+
+    PackedDist() = default;
+    PackedDist(wT w, int hops, int v, int p) : PackedDist(fromKey(encode(w), hops, v, p)) {}
+
+    static PackedDist fromKey(uint64_t key, int hops, int v, int p) {
+        PackedDist r;
+        r.dist = key;
+        r.hops_vertex = (static_cast<uint64_t>(static_cast<uint32_t>(hops)) << 32) | static_cast<uint32_t>(v);
+        r.pred = p;
+        return r;
+    }
+
+    // Floating point lengths are rounded to 1e-10 first, so sums taken in different
+    // orders compare equal; integer lengths need no rounding.
+    static inline uint64_t encode(wT w) {
+        if constexpr (std::is_floating_point_v<wT>) {
+            const double x = std::round(static_cast<double>(w) * SCALE) * SCALE_INV + 0.0; // folds -0.0
+            const uint64_t bits = std::bit_cast<uint64_t>(x);
+            return (bits >> 63) ? ~bits : bits | (1ull << 63);
+        } else {
+            return static_cast<uint64_t>(static_cast<int64_t>(w)) ^ (1ull << 63);
+        }
+    }
+
+    int vertex() const { return static_cast<int>(static_cast<uint32_t>(hops_vertex)); }
+    int hops() const { return static_cast<int>(hops_vertex >> 32); }
+
+    // Greatest key below this one, for block upper bounds.
+    PackedDist below() const {
+        PackedDist r = *this;
+        r.pred--;
+        return r;
+    }
 
-template <class Compare>
-struct CompareRefType {
-  // Pass the comparator by lvalue reference. Or in debug mode, using a
-  // debugging wrapper that stores a reference.
-  using type = typename std::add_lvalue_reference<Compare>::type;
+    friend bool operator==(const PackedDist&, const PackedDist&) = default;
+    friend auto operator<=>(const PackedDist&, const PackedDist&) = default;
 };
 
-template <class Iter, class Compare,
-          class DiffType = typename std::iterator_traits<Iter>::difference_type>
-inline void floyd_rivest_select_loop(Iter begin, DiffType left, DiffType right,
-                                     DiffType k, Compare comp) {
-  while (right > left) {
-    DiffType size = right - left;
-    if (size > floyd_rivest_constants::kQCap) {
-      DiffType n = right - left + 1;
-      DiffType i = k - left + 1;
-
-      double z = log(n);
-      double s = 0.5 * exp(2 * z / 3);
-      double sd = 0.5 * sqrt(z * s * (n - s) / n);
-      if (i < n / 2) {
-        sd *= -1.0;
-      }
-      DiffType new_left =
-          std::max(left, static_cast<DiffType>(k - i * s / n + sd));
-      DiffType new_right =
-          std::min(right, static_cast<DiffType>(k + (n - i) * s / n + sd));
-      floyd_rivest_select_loop<Iter, Compare, DiffType>(begin, new_left,
-                                                        new_right, k, comp);
-    }
-    DiffType i = left;
-    DiffType j = right;
-
-    std::swap(begin[left], begin[k]);
-    const bool to_swap = comp(begin[left], begin[right]);
-    if (to_swap) {
-      std::swap(begin[left], begin[right]);
-    }
-    // Make sure that non copyable types compile.
-    const auto& t = to_swap ? begin[left] : begin[right];
-    while (i < j) {
-      std::swap(begin[i], begin[j]);
-      i++;
-      j--;
-      while (comp(begin[i], t)) {
-        i++;
-      }
-      while (comp(t, begin[j])) {
-        j--;
-      }
-    }
-
-    if (to_swap) {
-      std::swap(begin[left], begin[j]);
-    } else {
-      j++;
-      std::swap(begin[right], begin[j]);
-    }
-
-    if (j <= k) {
-      left = j + 1;
-    }
-    if (k <= j) {
-      right = j - 1;
-    }
-  }
-}
-
-template <class Iter, class Compare>
-inline void floyd_rivest_partial_sort(Iter begin, Iter mid, Iter end,
-                                      Compare comp) {
-  if (begin == end) return;
-  if (begin == mid) return;
-  using CompType = CompareRefType<Compare>::type;
-  using DiffType = std::iterator_traits<Iter>::difference_type;
-  floyd_rivest_select_loop<Iter, CompType>(
-      begin, DiffType{0}, static_cast<DiffType>(end - begin - 1),
-      static_cast<DiffType>(mid - begin - 1), comp);
-  // std::sort proved to be better than other sorts because of pivoting.
-  std::sort<Iter, CompType>(begin, mid, comp);
-}
-
-template <class Iter>
-inline void floyd_rivest_partial_sort(Iter begin, Iter mid, Iter end) {
-  typedef typename std::iterator_traits<Iter>::value_type T;
-  floyd_rivest_partial_sort(begin, mid, end, std::less<T>());
-}
-
-template <class Iter, class Compare>
-inline void floyd_rivest_select(Iter begin, Iter mid, Iter end, Compare comp) {
-  if (mid == end) return;
-  using CompType = CompareRefType<Compare>::type;
-  using DiffType = std::iterator_traits<Iter>::difference_type;
-  floyd_rivest_select_loop<Iter, CompType>(
-      begin, DiffType{0}, static_cast<DiffType>(end - begin - 1),
-      static_cast<DiffType>(mid - begin), comp);
-}
-
-template <class Iter>
-inline void floyd_rivest_select(Iter begin, Iter mid, Iter end) {
-  typedef typename std::iterator_traits<Iter>::value_type T;
-  floyd_rivest_select(begin, mid, end, std::less<T>());
-}
+// Vertex-indexed element positions for BlockingBasedHeap. One allocation backs the
+// heaps of all recursion levels, each level owning an n-sized stripe. A slot is live
+// only while its stamp equals the owning heap's generation, so clearing a heap is a
+// counter bump instead of an O(n) wipe.
+class BlockingHeapIndex {
+public:
+    struct Slot {
+        int block, pos;
+        unsigned stamp;
+    };
 
+    void assign(int levels, int n_) {
+        n = n_;
+        slots.assign(static_cast<size_t>(levels) * n, Slot{-1, -1, 0});
+    }
+
+    Slot* stripe(int level) {
+        return slots.data() + static_cast<size_t>(level) * n;
+    }
+
+    int stripeSize() const {
+        return n;
+    }
+
+private:
+    std::vector<Slot> slots;
+    int n = 0;
+};
 
 template<typename uniqueDistT>
 class BlockingBasedHeap { // batch priority queue
-    template<typename K, typename V>
-    using hash_map = std::unordered_map<K, V>;
+    using Slot = BlockingHeapIndex::Slot;
     using elementT = std::pair<int, uniqueDistT>;
 
-    struct CompareUB {
-        template <typename It>
-        bool operator()(const std::pair<uniqueDistT, It>& a, const std::pair<uniqueDistT, It>& b) const {
-            if (a.first != b.first) return a.first < b.first;
-            return  addressof(*a.second) < addressof(*b.second);
-        }
+    // Blocks are contiguous arrays taken from a per-heap pool. A released block keeps
+    // its storage, so after warm-up insert/split/batchPrepend do not allocate. Capacity
+    // grows on demand up to M + 1 rather than being reserved up front: at the top
+    // level M exceeds n.
+    struct Block {
+        std::vector<elementT> items; // unordered inside the block
+        uniqueDistT ub;              // D1 only
+        int prev = -1, next = -1;    // D0 intrusive links
+        bool in_d1 = false;
     };
+    std::vector<Block> pool;
+    std::vector<int> free_blocks;
 
-    typename std::list<std::list<elementT>>::iterator it_min;
-
-    std::list<std::list<elementT>> D0,D1;
-    std::set<std::pair<uniqueDistT,typename std::list<std::list<elementT>>::iterator>,CompareUB> UBs;
+    int d0_head = -1;
+    std::vector<std::pair<uniqueDistT, int>> UBs; // D1 blocks in sequence order, sorted by UB
 
     int M,size_;
     uniqueDistT B;
 
-    hash_map<int, uniqueDistT> actual_value;
-    hash_map<int, std::pair<typename std::list<std::list<elementT>>::iterator, typename std::list<elementT>::iterator>> where_is0, where_is1;
+    Slot *where_is; // this level's stripe of the shared index
+    int n;
+    unsigned gen = 0;
+
+    std::vector<elementT> scratch; // candidates of pull() and batchPrepend()
+    int filling = -1;              // D0 block being built by batchPrepend()
 
 public:
+    // operation counts, kept until the owner clears them
+    struct Counters {
+        long long inserts = 0, pulls = 0, pulled = 0, splits = 0, prepends = 0, prepended = 0;
+    };
+    Counters counters;
 
-    BlockingBasedHeap(int n): actual_value(n), where_is0(n), where_is1(n){} // O(n)
+    BlockingBasedHeap(BlockingHeapIndex &index, int level)
+        : where_is(index.stripe(level)), n(index.stripeSize()) {}
 
-    void initialize(int M_, uniqueDistT B_) { // O(1)
+    void initialize(int M_, uniqueDistT B_) { // O(live blocks)
         M = M_; B = B_;
-        D0 = {};
-        D1 = {std::list<elementT>()};
-        UBs = {make_pair(B_,D1.begin())};
-        size_ = 0;
-
-        actual_value.clear();
-        where_is0.clear(); where_is1.clear();
+        reset();
+        if(++gen == 0){ // stamps wrapped around, forget them all
+            for(int i = 0; i < n; i++) where_is[i].stamp = 0;
+            gen = 1;
+        }
     }
 
     int size(){
@@ -174,370 +160,639 @@ public:
     }
 
     void insert(uniqueDistT x){ // O(lg(Block Numbers))
+        counters.inserts++;
         uniqueDistT b = x;
-        int a = get<2>(b);
+        int a = b.vertex();
 
         // checking if exists
-        auto it_exist = actual_value.find(a);
-        int exist = (it_exist != actual_value.end());
-
-        if(exist && it_exist->second > b){
-            delete_(x);
-        }else if(exist){
-            return;
+        if(contains(a)){
+            if(value(where_is[a]) > b) delete_(a);
+            else return;
         }
 
-        // Searching for the first block with UB which is >
-        auto it_UB_block = UBs.lower_bound({b,it_min});
-        auto [ub,it_block] = (*it_UB_block);
+        // Searching for the first block with UB which is >=
+        auto it_UB = std::lower_bound(UBs.begin(), UBs.end(), b,
+            [](const std::pair<uniqueDistT, int> &e, const uniqueDistT &v) { return e.first < v; });
+        const int blk = it_UB->second;
 
         // Inserting key/value (a,b)
-        auto it = it_block->insert(it_block->end(),{a,b});
-        where_is1[a] = {it_block, it};
-        actual_value[a] = b;
-
+        place(blk, a, b);
         size_++;
 
         // Checking if exceeds the sixe limit M
-        if((*it_block).size() > M){
-            split(it_block);
+        if(pool[blk].items.size() > M){
+            split(it_UB - UBs.begin());
         }
     }
 
-    void batchPrepend(const std::vector<uniqueDistT> &v){
-        std::list<elementT> l;
-        for(auto x: v){
-            l.push_back({get<2>(x),x});
-        }
-        batchPrepend(l);
+    void batchPrepend(const std::vector<uniqueDistT> &v){ // O(|v| log(|v|/M) )
+        if(v.empty()) return;
+        counters.prepends++;
+        counters.prepended += v.size();
+        scratch.clear();
+        for(const auto &x: v) scratch.emplace_back(x.vertex(), x);
+        batchPrepend(0, scratch.size());
     }
 
-    std::pair<uniqueDistT, std::vector<int>> pull(){ // O(M)
-        std::vector<elementT> s0,s1;
-        s0.reserve(2 * M); s1.reserve(M);
-
-        auto it_block = D0.begin();
-        while(it_block != D0.end() && s0.size() <= M){ // O(M)
-            for (const auto& x : *it_block) s0.push_back(x);
-            it_block++;
+    // Moves the smallest up to M vertices into ret and returns the bound separating them from the rest.
+    uniqueDistT pull(std::vector<int> &ret){ // O(M)
+        counters.pulls++;
+        ret.clear();
+        scratch.clear();
+        for(int b = d0_head; b != -1 && scratch.size() <= M; b = pool[b].next){ // O(M)
+            scratch.insert(scratch.end(), pool[b].items.begin(), pool[b].items.end());
         }
-
-        it_block = D1.begin();
-        while(it_block != D1.end() && s1.size() <= M){   //O(M)
-            for (const auto& x : *it_block) s1.push_back(x);
-            it_block++;
+        const size_t s0 = scratch.size();
+        for(size_t i = 0; i < UBs.size() && scratch.size() - s0 <= M; i++){ // O(M)
+            const auto &items = pool[UBs[i].second].items;
+            scratch.insert(scratch.end(), items.begin(), items.end());
         }
 
-        if(s1.size() + s0.size() <= M){
-            std::vector<int> ret;
-            ret.reserve(s1.size()+s0.size());
-            for(auto [a,b] : s0) {
+        if(scratch.size() <= M){
+            // both scans reached the end, so this drains the heap
+            for(const auto &[a, b]: scratch){
                 ret.push_back(a);
-                delete_({b});
+                where_is[a].stamp = 0;
             }
-            for(auto [a,b] : s1){
-                ret.push_back(a);
-                delete_({b});
-            }
-
-            return {B, ret};
+            reset();
+            counters.pulled += ret.size();
+            return B;
         }else{
-            std::vector<elementT> &l = s0;
-            l.insert(l.end(), s1.begin(), s1.end());
-
-            uniqueDistT med = selectKth(l, M);
-            std::vector<int> ret;
-            ret.reserve(M);
-            for(auto [a,b]: l){
+            uniqueDistT med = selectKth(scratch, M);
+            for(const auto &[a, b]: scratch){
                 if(b < med) {
                     ret.push_back(a);
-                    delete_({b});
+                    delete_(a);
                 }
             }
-            return {med,ret};
+            counters.pulled += ret.size();
+            return med;
         }
     }
     inline void erase(int key) {
-        if(actual_value.find(key) != actual_value.end())
-            delete_({-1, -1, key, -1});
+        if(contains(key))
+            delete_(key);
     }
 
 private:
-    void delete_(uniqueDistT x){
-        int a = get<2>(x);
-        uniqueDistT b = actual_value[a];
+    int acquire() {
+        if(free_blocks.empty()){
+            pool.emplace_back();
+            return static_cast<int>(pool.size()) - 1;
+        }
+        int b = free_blocks.back();
+        free_blocks.pop_back();
+        return b;
+    }
+
+    void release(int b) {
+        pool[b].items.clear();
+        free_blocks.push_back(b);
+    }
+
+    void reset() {
+        for(int b = d0_head; b != -1;){
+            int nxt = pool[b].next;
+            release(b);
+            b = nxt;
+        }
+        for(const auto &[ub, b]: UBs) release(b);
+        d0_head = -1;
 
-        auto it_w = where_is1.find(a);
-        if((it_w != where_is1.end())){
-            auto [it_block,it] = it_w->second;
+        const int first = acquire();
+        pool[first].in_d1 = true;
+        pool[first].ub = B;
+        UBs.assign(1, {B, first});
+        size_ = 0;
+    }
 
-            (*it_block).erase(it);
-            where_is1.erase(a);
+    inline bool contains(int a) const {
+        return where_is[a].stamp == gen;
+    }
 
-            if((*it_block).size() == 0){
-                auto it_UB_block = UBs.lower_bound({b,it_block});
+    inline const uniqueDistT &value(const Slot &s) {
+        return pool[s.block].items[s.pos].second;
+    }
 
-                if((*it_UB_block).first != B){
-                    UBs.erase(it_UB_block);
-                    D1.erase(it_block);
-                }
+    inline void place(int blk, int a, const uniqueDistT &b) {
+        auto &items = pool[blk].items;
+        items.emplace_back(a, b);
+        where_is[a] = {blk, static_cast<int>(items.size()) - 1, gen};
+    }
+
+    void reindex(int blk) {
+        const auto &items = pool[blk].items;
+        for(int i = 0; i < items.size(); i++) where_is[items[i].first] = {blk, i, gen};
+    }
+
+    void delete_(int a){
+        const Slot s = where_is[a];
+        where_is[a].stamp = 0;
+        size_--;
+
+        auto &items = pool[s.block].items;
+        if(s.pos + 1 != items.size()){
+            items[s.pos] = items.back();
+            where_is[items[s.pos].first].pos = s.pos;
+        }
+        items.pop_back();
+        if(!items.empty() || s.block == filling) return;
+
+        Block &blk = pool[s.block];
+        if(blk.in_d1){
+            if(blk.ub != B){
+                auto it_UB = std::lower_bound(UBs.begin(), UBs.end(), blk.ub,
+                    [](const std::pair<uniqueDistT, int> &e, const uniqueDistT &v) { return e.first < v; });
+                while(it_UB->second != s.block) it_UB++;
+                UBs.erase(it_UB);
+                release(s.block);
             }
         }else{
-            auto [it_block,it] = where_is0[a];
-            (*it_block).erase(it);
-            where_is0.erase(a);
-            if((*it_block).size() == 0) D0.erase(it_block);
+            unlinkD0(s.block);
+            release(s.block);
         }
+    }
 
-        actual_value.erase(a);
-        size_--;
+    void pushFrontD0(int b) {
+        pool[b].in_d1 = false;
+        pool[b].prev = -1;
+        pool[b].next = d0_head;
+        if(d0_head != -1) pool[d0_head].prev = b;
+        d0_head = b;
+    }
+
+    void unlinkD0(int b) {
+        const int p = pool[b].prev, nx = pool[b].next;
+        if(p != -1) pool[p].next = nx;
+        else d0_head = nx;
+        if(nx != -1) pool[nx].prev = p;
     }
 
     uniqueDistT selectKth(std::vector<elementT> &v, int k) {
+        return selectKth(v.begin(), v.end(), k);
+    }
+
+    template<class Iter>
+    uniqueDistT selectKth(Iter first, Iter last, int k) {
         const auto comparator = [](const auto &a, const auto &b){
             return a.second < b.second;
         };
-        floyd_rivest_select(v.begin(), v.begin() + k, v.end(), comparator);
-        return v[k].second;
+        select_nth(first, first + k, last, comparator);
+        return first[k].second;
     }
 
 
-    void split(std::list<std::list<elementT>>::iterator it_block){ // O(M) + O(lg(Block Numbers))
-        int sz = (*it_block).size();
-
-        std::vector<elementT> v((*it_block).begin() , (*it_block).end());
-        uniqueDistT med = selectKth(v,(sz/2)); // O(M)
+    void split(size_t ub_idx){ // O(M) + O(Block Numbers)
+        counters.splits++;
+        const int blk = UBs[ub_idx].second;
+        const int nb = acquire(); // may grow the pool, take references after this
+        auto &items = pool[blk].items;
+        const int sz = items.size();
 
-        auto pos = it_block;
-        pos++;
-
-        auto new_block = D1.insert(pos,std::list<elementT>());
-        auto it = (*it_block).begin();
-
-        while(it != (*it_block).end()){ // O(M)
-            if((*it).second >= med){
-                (*new_block).push_back(move(*it));
-                auto it_new = (*new_block).end(); it_new--;
-                where_is1[(*it).first] = {new_block, it_new};
-
-                it = (*it_block).erase(it);
-            }else{
-                it++;
-            }
-        }
+        uniqueDistT med = selectKth(items.begin(), items.end(), sz / 2); // O(M)
 
+        pool[nb].in_d1 = true;
+        pool[nb].items.assign(items.begin() + sz / 2, items.end());
+        items.resize(sz / 2);
+        reindex(blk);
+        reindex(nb);
 
         // Updating UBs
-        // O(lg(Block Numbers))
-        uniqueDistT UB1 = {get<0>(med),get<1>(med),get<2>(med),get<3>(med)-1};
-        auto it_lb = UBs.lower_bound({UB1,it_min});
-        auto [UB2,aux] = (*it_lb);
-
-        UBs.insert({UB1,it_block});
-        UBs.insert({UB2,new_block});
-
-        UBs.erase(it_lb);
+        uniqueDistT UB1 = med.below();
+        uniqueDistT UB2 = UBs[ub_idx].first;
+        pool[blk].ub = UB1;
+        pool[nb].ub = UB2;
+        UBs[ub_idx].first = UB1;
+        UBs.insert(UBs.begin() + ub_idx + 1, {UB2, nb});
     }
 
-    void batchPrepend(const std::list<elementT> &l) { // O(|l| log(|l|/M) )
-        int sz = l.size();
-
+    void batchPrepend(size_t lo, size_t hi) { // prepends scratch[lo, hi)
+        const size_t sz = hi - lo;
         if(sz == 0) return;
         if(sz <= M){
-
-            D0.push_front(std::list<elementT>());
-            auto new_block = D0.begin();
-
-            for(auto &x : l){
-                auto it = actual_value.find(x.first);
-                int exist = (it != actual_value.end());
-
-                if(exist && it->second > x.second){
-                    delete_(x.second);
-                }else if(exist){
-                    continue;
+            const int nb = acquire();
+            pushFrontD0(nb);
+            filling = nb;
+            for(size_t i = lo; i < hi; i++){
+                const auto [a, b] = scratch[i];
+                if(contains(a)){
+                    if(value(where_is[a]) > b) delete_(a);
+                    else continue;
                 }
-
-                (*new_block).push_back(x);
-                auto it_new = (*new_block).end(); it_new--;
-                where_is0[x.first] = {new_block, it_new};
-                actual_value[x.first] = x.second;
+                place(nb, a, b);
                 size_++;
             }
-            if(new_block->size() == 0) D0.erase(new_block);
+            filling = -1;
+            if(pool[nb].items.empty()){
+                unlinkD0(nb);
+                release(nb);
+            }
             return;
         }
 
-        std::vector<elementT> v(l.begin(), l.end());
-        uniqueDistT med = selectKth(v, sz/2);
+        // [lo, mid) <= scratch[mid] <= [mid, hi); the smaller half must end up in front
+        const size_t mid = lo + sz / 2;
+        selectKth(scratch.begin() + lo, scratch.begin() + hi, sz / 2);
+        batchPrepend(mid, hi);
+        batchPrepend(lo, mid);
+    }
+};
+
+// Compressed sparse row adjacency: the out-edges of u are edges[offset[u], offset[u + 1]).
+template<typename wT>
+struct CsrAdjacency {
+    std::vector<size_t> offset{0};
+    std::vector<std::pair<int, wT>> edges;
 
-        std::list<elementT> less,great;
-        for(auto [a,b]: l){
-            if(b < med){
-                less.push_back({a,b});
-            }else if(b > med){
-                great.push_back({a,b});
-            }
-        }
+    size_t size() const {
+        return offset.size() - 1;
+    }
 
-        great.push_back({get<2>(med),med});
+    std::span<const std::pair<int, wT>> operator[](size_t u) const {
+        return {edges.data() + offset[u], edges.data() + offset[u + 1]};
+    }
 
-        batchPrepend(great);
-        batchPrepend(less);
+    void assign_offsets(const std::vector<size_t> &degree) {
+        offset.assign(degree.size() + 1, 0);
+        for(size_t u = 0; u < degree.size(); u++) offset[u + 1] = offset[u] + degree[u];
+        edges.assign(offset.back(), {});
     }
 };
 
-template<typename wT>
-class bmssp { // bmssp class
-    int n, k, t, l;
-
-    std::vector<std::vector<std::pair<int, wT>>> ori_adj;
-    std::vector<std::vector<std::pair<int, wT>>> adj;
-    std::vector<wT> d;
-    std::vector<int> pred, path_sz;
+// Where query time went, accumulated since the last reset_stats(). Recursion time is
+// total_ms minus the two leaf regimes.
+struct BmsspStats {
+    long long queries = 0;
+    double total_ms = 0, base_case_ms = 0, hybrid_ms = 0; // total_ms is the recursion, leaves included
+    double setup_ms = 0;   // log file and array resets before the recursion
+    double extract_ms = 0; // mapping answers back to the original vertices
+    long long base_case_calls = 0, hybrid_calls = 0;
+};
 
-    std::vector<int> node_map, node_rev_map;
+// Totals of one recursion level since the last reset_stats(). Times are self times, the
+// levels below are not included; leaves are base cases (level 0) and hybrid Dijkstras.
+struct BmsspLevelProfile {
+    int level = 0;
+    long long calls = 0, leaf_calls = 0;
+    long long pivot_sources = 0, pivots = 0, pivot_visited = 0; // findPivots |S|, |P|, |W|
+    long long inserts = 0, pulls = 0, pulled = 0, splits = 0, prepends = 0, prepended = 0; // BlockingBasedHeap
+    long long heap_pushes = 0, heap_pops = 0; // leaf Dijkstra
+    double pivot_ms = 0, pull_ms = 0, relax_ms = 0, prepend_ms = 0, leaf_ms = 0;
+};
 
+// Everything a query only reads: the prepared graph, the vertex maps and the resolved
+// parameters. Built once, it can be shared by any number of BmsspQueryContexts.
+template<typename wT>
+struct BmsspPreparedGraph {
+    int n; // original vertices
+    int k, t, l;
+    std::vector<int> block_size; // M of the BlockingBasedHeap at level i + 1
+    long long hybrid_cutoff = 0;
+    bool profile = false;
     bool cd_transfomed;
 
-public:
-    const wT oo = INF;
-    bmssp(int n_): n(n_) {
-        ori_adj.assign(n, {});
-    }
-    bmssp(const auto &adj) {
-        n = adj.size();
-        ori_adj = adj;
+    CsrAdjacency<wT> adj;
+    std::vector<int> node_map, node_rev_map;
+
+    // src[u] lists the (to, weight) out-edges of u, for n vertices; with
+    // constant_degree the graph gets the constant-degree transformation
+    static std::shared_ptr<const BmsspPreparedGraph> build(const auto &src, int n, bool constant_degree, const BmsspParams &params) {
+        auto g = std::make_shared<BmsspPreparedGraph>();
+        g->n = n;
+        g->cd_transfomed = constant_degree;
+        if(constant_degree) {
+            g->build_constant_degree(src);
+        } else {
+            g->build_deduplicated(src);
+            g->node_map.resize(n);
+            g->node_rev_map.resize(n);
+            for(int i = 0; i < n; i++) {
+                g->node_map[i] = i;
+                g->node_rev_map[i] = i;
+            }
+        }
+        g->resolve_params(params);
+        return g;
     }
 
-    void addEdge(int a, int b, wT w) {
-        ori_adj[a].emplace_back(b, w);
+    // k, t, the per-level M and the hybrid cutoff actually in use
+    BmsspParams effective_params() const {
+        BmsspParams p;
+        p.k = k;
+        p.t = t;
+        p.block_sizes.assign(block_size.begin(), block_size.end());
+        p.hybrid_cutoff = hybrid_cutoff;
+        p.profile = profile;
+        return p;
     }
 
-    // if the graph already has constant degree, prepage_graph(false)
-    // else, prepage_graph(true)
-    void prepare_graph(bool exec_constant_degree_trasnformation = false) {
-        cd_transfomed = exec_constant_degree_trasnformation;
-        // erase duplicated edges
-        std::vector<std::pair<int, int>> tmp_edges(n, {-1, -1});
-        for(int i = 0; i < n; i++) {
-            std::vector<std::pair<int, wT>> nw_adj;
-            nw_adj.reserve(ori_adj[i].size());
-            for(auto [j, w]: ori_adj[i]) {
-                if(tmp_edges[j].first != i) {
-                    nw_adj.emplace_back(j, w);
-                    tmp_edges[j] = {i, nw_adj.size() - 1};
-                } else {
-                    int id = tmp_edges[j].second;
-                    nw_adj[id].second = std::min(nw_adj[id].second, w);
-                }
-            }
-            ori_adj[i] = move(nw_adj);
+private:
+    void resolve_params(const BmsspParams &params) {
+        const double lg = log2(adj.size());
+        k = params.k > 0 ? params.k : floor(pow(lg, 1.0 / 3.0));
+        t = params.t > 0 ? params.t : floor(pow(lg, 2.0 / 3.0));
+        k = std::max(k, 1);
+        t = std::clamp(t, 1, 30); // keeps the 2^(l * t) quotas within long long
+        l = std::max(1, (int)ceil(lg / t));
+
+        // an M beyond the node count behaves like the node count
+        block_size.resize(l);
+        for(int i = 0; i < l; i++) {
+            double m = i < (int)params.block_sizes.size() ? params.block_sizes[i]
+                                                           : params.block_scale * std::ldexp(1.0, i * t);
+            block_size[i] = std::clamp<double>(std::llround(m), 1, adj.size());
         }
-        tmp_edges.clear();
 
-        if(exec_constant_degree_trasnformation == false) {
-            adj = move(ori_adj);
-            node_map.resize(n);
-            node_rev_map.resize(n);
+        // auto: levels 1 and 2, never the top one; below that, heap setup, pivot search
+        // and prepends cost more than a Dijkstra over the same budget
+        const int hybrid_levels = std::min(2, l - 1);
+        if(params.hybrid_cutoff >= 0) hybrid_cutoff = params.hybrid_cutoff;
+        else hybrid_cutoff = hybrid_levels > 0 ? k * (1ll << (hybrid_levels * t)) : 0;
+        profile = params.profile;
+    }
 
-            for(int i = 0; i < n; i++) {
-                node_map[i] = i;
-                node_rev_map[i] = i;
+    // erase duplicated edges, keeping the cheapest one in first-occurrence order
+    void build_deduplicated(const auto &src) {
+        std::vector<size_t> deg(n);
+        parallel::for_chunks(n, [&](size_t lo, size_t hi) {
+            std::vector<int> seen(n, -1);
+            for(int i = lo; i < hi; i++) {
+                size_t cnt = 0;
+                for(auto [j, w]: src[i]) {
+                    if(seen[j] != i) {
+                        seen[j] = i;
+                        cnt++;
+                    }
+                }
+                deg[i] = cnt;
             }
-
-            k = floor(pow(log2(n), 1.0 / 3.0));
-            t = floor(pow(log2(n), 2.0 / 3.0));
-        } else { // Make the graph become constant degree
-            int cnt = 0;
-            std::vector<std::map<int, int>> edge_id(n);
-            for(int i = 0; i < n; i++) {
-                for(auto [j, w]: ori_adj[i]) {
-                    if(edge_id[i].find(j) == edge_id[i].end()) {
-                        edge_id[i][j] = cnt++;
-                        edge_id[j][i] = cnt++;
+        }, 1 << 12);
+
+        adj.assign_offsets(deg);
+        parallel::for_chunks(n, [&](size_t lo, size_t hi) {
+            std::vector<int> seen(n, -1);
+            std::vector<size_t> at(n);
+            for(int i = lo; i < hi; i++) {
+                size_t pos = adj.offset[i];
+                for(auto [j, w]: src[i]) {
+                    if(seen[j] != i) {
+                        seen[j] = i;
+                        at[j] = pos;
+                        adj.edges[pos++] = {j, static_cast<wT>(w)};
+                    } else {
+                        adj.edges[at[j]].second = std::min(adj.edges[at[j]].second, static_cast<wT>(w));
                     }
                 }
             }
+        }, 1 << 12);
+    }
 
-            cnt++;
-            adj.assign(cnt, {});
-            node_map.resize(cnt);
-            node_rev_map.resize(cnt);
-
-            for(int i = 0; i < n; i++) { // create 0-weight cycles
-                for(auto cur = edge_id[i].begin(); cur != edge_id[i].end(); cur++) {
-                    auto nxt = next(cur);
-                    if(nxt == edge_id[i].end()) nxt = edge_id[i].begin();
-                    adj[cur->second].emplace_back(nxt->second, wT());
-                    node_rev_map[cur->second] = i;
+    // Every vertex i becomes a 0-weight cycle with one node per neighbour j (in or out),
+    // ordered by j; node (i, j) carries the edge i -> j to node (j, i). Node ids come
+    // from a counting-sort (radix) pass over the (i, j) pairs, and prefix sums lay the
+    // result out directly as CSR.
+    void build_constant_degree(const auto &src) {
+        struct Entry {
+            wT w;
+            int nb;
+            bool real; // i -> nb exists; otherwise only nb -> i does
+        };
+
+        // transpose by counting sort: in-edges of every v, sources ascending
+        std::vector<size_t> in_off(n + 1, 0);
+        for(int i = 0; i < n; i++) for(auto [j, w]: src[i]) in_off[j + 1]++;
+        for(int i = 0; i < n; i++) in_off[i + 1] += in_off[i];
+        std::vector<std::pair<int, wT>> in_edges(in_off[n]);
+        {
+            std::vector<size_t> at(in_off.begin(), in_off.end() - 1);
+            for(int i = 0; i < n; i++) for(auto [j, w]: src[i]) in_edges[at[j]++] = {i, static_cast<wT>(w)};
+        }
+
+        // bucket entries by owner, scattering in ascending neighbour order
+        std::vector<size_t> own_off(n + 1, 0);
+        for(int i = 0; i < n; i++) own_off[i + 1] = src[i].size() + (in_off[i + 1] - in_off[i]);
+        for(int i = 0; i < n; i++) own_off[i + 1] += own_off[i];
+        std::vector<Entry> entries(own_off[n]);
+        {
+            std::vector<size_t> at(own_off.begin(), own_off.end() - 1);
+            for(int x = 0; x < n; x++) {
+                for(size_t e = in_off[x]; e < in_off[x + 1]; e++) {
+                    auto [i, w] = in_edges[e];
+                    entries[at[i]++] = {w, x, true};
                 }
+                for(auto [j, w]: src[x]) entries[at[j]++] = {wT(), x, false};
             }
-            for(int i = 0; i < n; i++) { // add edges
-                for(auto [j, w]: ori_adj[i]) {
-                    adj[edge_id[i][j]].emplace_back(edge_id[j][i], w);
+        }
+        in_edges = {};
+        in_off = {};
+
+        // dedupe each owner's sorted run in parallel; owner i gets ids [id_off[i], id_off[i + 1])
+        std::vector<size_t> id_off(n + 1, 0);
+        parallel::for_chunks(n, [&](size_t lo, size_t hi) {
+            for(size_t i = lo; i < hi; i++) {
+                size_t cnt = 0;
+                for(size_t e = own_off[i]; e < own_off[i + 1]; e++) {
+                    if(e == own_off[i] || entries[e].nb != entries[e - 1].nb) cnt++;
                 }
-                if(edge_id[i].size()) {
-                    node_map[i] = edge_id[i].begin()->second;
-                } else {
-                    node_map[i] = cnt - 1;
+                id_off[i + 1] = cnt;
+            }
+        });
+        for(int i = 0; i < n; i++) id_off[i + 1] += id_off[i];
+        const size_t pairs = id_off[n];
+
+        std::vector<int> nb(pairs);
+        std::vector<char> has_real(pairs, 0);
+        std::vector<wT> real_w(pairs);
+        parallel::for_chunks(n, [&](size_t lo, size_t hi) {
+            for(size_t i = lo; i < hi; i++) {
+                size_t id = id_off[i] - 1;
+                for(size_t e = own_off[i]; e < own_off[i + 1]; e++) {
+                    const Entry &en = entries[e];
+                    if(e == own_off[i] || en.nb != entries[e - 1].nb) nb[++id] = en.nb;
+                    if(!en.real) continue;
+                    real_w[id] = has_real[id] ? std::min(real_w[id], en.w) : en.w;
+                    has_real[id] = 1;
                 }
             }
+        });
+        entries = {};
+        own_off = {};
 
-            ori_adj.clear();
+        // the pair set is symmetric, so a stable counting sort of the ids by neighbour
+        // lists them in (j, i) order: the rank of (i, j) there is the id of (j, i)
+        std::vector<int> rev(pairs);
+        {
+            std::vector<size_t> at(id_off.begin(), id_off.end() - 1);
+            for(size_t id = 0; id < pairs; id++) rev[id] = at[nb[id]]++;
+        }
+        nb = {};
+
+        // isolated vertices get a node of their own
+        int isolated = 0;
+        for(int i = 0; i < n; i++) if(id_off[i] == id_off[i + 1]) isolated++;
+        const size_t nodes = pairs + isolated;
+
+        std::vector<size_t> deg(nodes, 0);
+        for(size_t id = 0; id < pairs; id++) deg[id] = 1 + has_real[id];
+        adj.assign_offsets(deg);
+        node_map.resize(n);
+        node_rev_map.resize(nodes);
+
+        parallel::for_chunks(n, [&](size_t lo, size_t hi) {
+            for(size_t i = lo; i < hi; i++) {
+                for(size_t id = id_off[i]; id < id_off[i + 1]; id++) { // create 0-weight cycles, then add edges
+                    const size_t nxt = id + 1 == id_off[i + 1] ? id_off[i] : id + 1;
+                    size_t pos = adj.offset[id];
+                    adj.edges[pos++] = {static_cast<int>(nxt), wT()};
+                    if(has_real[id]) adj.edges[pos] = {rev[id], real_w[id]};
+                    node_rev_map[id] = i;
+                }
+            }
+        });
+        int next_isolated = pairs;
+        for(int i = 0; i < n; i++) {
+            if(id_off[i] != id_off[i + 1]) {
+                node_map[i] = id_off[i];
+            } else {
+                node_map[i] = next_isolated;
+                node_rev_map[next_isolated++] = i;
+            }
         }
+    }
+};
+
+// Mutable state of one query at a time over a shared BmsspPreparedGraph. Queries on
+// one prepared graph can run concurrently, each thread with its own context.
+template<typename wT>
+class BmsspQueryContext {
+    std::shared_ptr<const BmsspPreparedGraph<wT>> graph;
+    // read-only aliases into *graph
+    const int n, k, t, l;
+    const std::vector<int> &block_size;
+    const long long hybrid_cutoff;
+    const bool profiling;
+    const bool cd_transfomed;
+    const CsrAdjacency<wT> &adj;
+    const std::vector<int> &node_map, &node_rev_map;
+
+    std::string log_filename; // no trace unless set_log_file() names one
+    BmsspStats stats;
+    std::vector<BmsspLevelProfile> level_profile; // by level, 0 .. l
 
+    std::vector<wT> d;
+    std::vector<int> pred, path_sz;
 
+public:
+    const wT oo = INF;
+
+    explicit BmsspQueryContext(std::shared_ptr<const BmsspPreparedGraph<wT>> g)
+        : graph(std::move(g)), n(graph->n), k(graph->k), t(graph->t), l(graph->l),
+          block_size(graph->block_size), hybrid_cutoff(graph->hybrid_cutoff),
+          profiling(graph->profile), cd_transfomed(graph->cd_transfomed),
+          adj(graph->adj), node_map(graph->node_map), node_rev_map(graph->node_rev_map) {
         d.resize(adj.size());
+        d_key.resize(adj.size());
         root.resize(adj.size());
         pred.resize(adj.size());
         treesz.resize(adj.size());
         path_sz.resize(adj.size(), 0);
         last_complete_lvl.resize(adj.size());
         pivot_vis.resize(adj.size());
-        k = floor(pow(log2(adj.size()), 1.0 / 3.0));
-        t = floor(pow(log2(adj.size()), 2.0 / 3.0));
-        l = ceil(log2(adj.size()) / t);
-        Ds.assign(l, adj.size());
+        relax_stamp.assign(adj.size(), 0u);
+        heap_index.assign(l, adj.size());
+        Ds.reserve(l);
+        for(int i = 0; i < l; i++) Ds.emplace_back(heap_index, i);
+        frames.resize(l + 1);
+        level_profile.assign(l + 1, {});
+        for(int i = 0; i <= l; i++) level_profile[i].level = i;
     }
 
-    std::pair<std::vector<wT>, std::vector<int>> execute(int s) {
-        std::ofstream log_file("bmssp.log");
-        if (!log_file.is_open()) {
-            std::cout << "Failed to open dijkstra.log file!";
+    // Ds point into heap_index, so a context stays where it was built
+    BmsspQueryContext(const BmsspQueryContext &) = delete;
+    BmsspQueryContext &operator=(const BmsspQueryContext &) = delete;
+
+    const BmsspPreparedGraph<wT> &prepared() const {
+        return *graph;
+    }
+
+    // trace of the search, rewritten by every query; off by default and when empty
+    void set_log_file(std::string filename) {
+        log_filename = std::move(filename);
+    }
+
+    const BmsspStats &get_stats() const {
+        return stats;
+    }
+
+    void reset_stats() {
+        stats = {};
+        for(auto &p: level_profile) p = {.level = p.level};
+        for(auto &D: Ds) D.counters = {};
+    }
+
+    // Levels 0 .. l; the heap counters are collected even when params.profile is off.
+    std::vector<BmsspLevelProfile> get_profile() const {
+        auto prof = level_profile;
+        for(int i = 0; i < (int)Ds.size(); i++) {
+            const auto &c = Ds[i].counters;
+            auto &p = prof[i + 1];
+            p.inserts = c.inserts;
+            p.pulls = c.pulls;
+            p.pulled = c.pulled;
+            p.splits = c.splits;
+            p.prepends = c.prepends;
+            p.prepended = c.prepended;
         }
-        fill(d.begin(), d.end(), oo);
-        fill(last_complete_lvl.begin(), last_complete_lvl.end(), -1);
-        fill(pivot_vis.begin(), pivot_vis.end(), -1);
-        for(int i = 0; i < pred.size(); i++) pred[i] = i;
+        return prof;
+    }
 
-        s = toAnyCustomNode(s);
-        d[s] = 0;
-        path_sz[s] = 0;
+    // Distances and predecessors of the original vertices. The spans point into the
+    // context and stay valid until its next query.
+    struct QueryView {
+        std::span<const wT> dist;
+        std::span<const int> pred;
+    };
 
-        const int l = ceil(log2(adj.size()) / t);
-        const uniqueDistT inf_dist = {oo, 0, 0, 0};
-        bmsspRec(l, inf_dist, {s}, log_file);
+    QueryView query(int s) {
+        if(!cd_transfomed) {
+            search(s);
+            return {{d.data(), (size_t)n}, {pred.data(), (size_t)n}};
+        }
+        out_dist.resize(n);
+        out_pred.resize(n);
+        execute_into(s, out_dist, out_pred);
+        return {out_dist, out_pred};
+    }
 
+    // Writes the answer into caller storage of n elements each, without allocating.
+    void execute_into(int s, std::span<wT> dist, std::span<int> real_pred) {
+        search(s);
+        const auto started = std::chrono::steady_clock::now();
         if(!cd_transfomed) {
-            return {d, pred};
+            std::copy_n(d.begin(), n, dist.begin());
+            std::copy_n(pred.begin(), n, real_pred.begin());
         } else {
-            std::vector<wT> ret_distance(n);
-            std::vector<int> ret_pred(n);
+            // getPred only walks the 0-weight cycle of the vertex itself, so the pass is O(N)
             for(int i = 0; i < n; i++) {
-                ret_distance[i] = d[toAnyCustomNode(i)];
-                ret_pred[i] = customToReal(getPred(toAnyCustomNode(i)));
+                const int u = toAnyCustomNode(i);
+                dist[i] = d[u];
+                real_pred[i] = customToReal(getPred(u));
             }
-            return {ret_distance, ret_pred};
         }
+        stats.extract_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    std::pair<std::vector<wT>, std::vector<int>> execute(int s) {
+        auto [dist, real_pred] = query(s);
+        return {{dist.begin(), dist.end()}, {real_pred.begin(), real_pred.end()}};
     }
 
-    std::vector<int> get_shortest_path(int real_u, const std::vector<int> &real_pred) {
+    std::vector<int> get_shortest_path(int real_u, std::span<const int> real_pred) {
         if(!cd_transfomed) {
             int u = real_u;
             if(d[u] == oo) return {};
 
-            int path_sz = get<1>(getDist(u)) + 1;
+            int path_sz = getDist(u).hops() + 1;
             std::vector<int> path(path_sz);
             for(int i = path_sz - 1; i >= 0; i--) {
                 path[i] = u;
@@ -548,7 +803,7 @@ public:
             int u = real_u;
             if(d[toAnyCustomNode(u)] == oo) return {};
 
-            int max_path_sz = get<1>(getDist(toAnyCustomNode(u))) + 1;
+            int max_path_sz = getDist(toAnyCustomNode(u)).hops() + 1;
             std::vector<int> path;
             path.reserve(max_path_sz);
 
@@ -564,6 +819,38 @@ public:
         }
     }
 private:
+    std::vector<wT> out_dist; // query() buffers for the constant-degree graph
+    std::vector<int> out_pred;
+
+    void search(int s) {
+        const auto entered = std::chrono::steady_clock::now();
+        std::ofstream log_file;
+        if(!log_filename.empty()) {
+            log_file.open(log_filename);
+            if (!log_file.is_open()) {
+                std::cerr << "Failed to open " << log_filename << "\n";
+            }
+        }
+        // pivot_vis needs no reset: counter_pivot only grows, and clears it when it wraps
+        fill(d.begin(), d.end(), oo);
+        fill(d_key.begin(), d_key.end(), uniqueDistT::encode(oo));
+        fill(last_complete_lvl.begin(), last_complete_lvl.end(), -1);
+        for(int i = 0; i < pred.size(); i++) pred[i] = i;
+
+        s = toAnyCustomNode(s);
+        d[s] = 0;
+        d_key[s] = uniqueDistT::encode(0);
+        path_sz[s] = 0;
+
+        const uniqueDistT inf_dist = {oo, 0, 0, 0};
+        source.assign(1, s);
+        const auto started = std::chrono::steady_clock::now();
+        stats.setup_ms += std::chrono::duration<double, std::milli>(started - entered).count();
+        bmsspRec(l, inf_dist, source, log_file);
+        stats.total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        stats.queries++;
+    }
+
     inline int toAnyCustomNode(int real_id) {
         return node_map[real_id];
     }
@@ -591,29 +878,20 @@ private:
     }
 
     // Unique distances helpers: Assumption 2.1
-    struct uniqueDistT : std::tuple<wT, int, int, int> {
-        static constexpr wT SCALE = 1e10;
-        static constexpr wT SCALE_INV = ((wT) 1.0) / SCALE;
-
-        uniqueDistT() = default;
-        static inline wT sanitize(wT w) {
-            if constexpr (std::is_floating_point_v<wT>) {
-                return std::round(w * SCALE) * SCALE_INV;
-            }
-            return w;
-        }
-        uniqueDistT(wT w, int i1, int i2, int i3)
-            : std::tuple<wT, int, int, int>(sanitize(w), i1, i2, i3) {}
-    };
+    using uniqueDistT = PackedDist<wT>;
+    std::vector<uint64_t> d_key; // encoded d, so reading a current distance never rounds
+
     inline uniqueDistT getDist(int u, int v, wT w) {
         return {d[u] + w, path_sz[u] + 1, v, u};
     }
     inline uniqueDistT getDist(int u) {
-        return {d[u], path_sz[u], u, pred[u]};
+        return uniqueDistT::fromKey(d_key[u], path_sz[u], u, pred[u]);
     }
-    void updateDist(int u, int v, wT w) {
+    // new_dist must be getDist(u, v, w)
+    void updateDist(int u, int v, wT w, const uniqueDistT &new_dist) {
         pred[v] = u;
         d[v] = d[u] + w;
+        d_key[v] = new_dist.dist;
         path_sz[v] = path_sz[u] + 1;
     }
 
@@ -621,71 +899,193 @@ private:
     std::vector<int> root;
     std::vector<short int> treesz;
 
-    int counter_pivot = 0;
-    std::vector<int> pivot_vis;
-    std::pair<std::vector<int>, std::vector<int>> findPivots(uniqueDistT B, const std::vector<int> &S, std::ofstream& log_file) { // Algorithm 1
-        counter_pivot++;
+    unsigned counter_pivot = 0;
+    std::vector<unsigned> pivot_vis;
 
-        std::vector<int> vis;
-        vis.reserve(2 * k * S.size());
-
-        for(int x: S) {
-            vis.push_back(x);
-            pivot_vis[x] = counter_pivot;
+    // Next value of a stamp counter. When it wraps, the stamps are cleared so that none
+    // left over from earlier queries matches again.
+    static unsigned nextStamp(unsigned &counter, std::vector<unsigned> &stamps) {
+        if(++counter == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0u);
+            counter = 1;
         }
+        return counter;
+    }
 
-        std::vector<int> active = S;
-        for(int x: S) root[x] = x, treesz[x] = 0;
-        for(int i = 1; i <= k; i++) {
-            std::vector<int> nw_active;
-            nw_active.reserve(active.size() * 4);
-            for(int u: active) {
+    // findPivots relaxes in synchronous rounds: candidates are computed from the
+    // distances at the start of the round, then each owner (a contiguous vertex range)
+    // applies the ones aimed at its vertices. The outcome does not depend on how the
+    // frontier is split, so serial and parallel runs give the same P and W, in the same order.
+    struct PivotCandidate {
+        uniqueDistT dist;
+        wT d;
+        int root;
+    };
+    static constexpr size_t pivot_grain = 1 << 13; // frontier per thread before going parallel
+    std::vector<std::vector<PivotCandidate>> pivot_bucket; // [chunk * owners + owner]
+    std::vector<std::vector<int>> pivot_touched, pivot_new_vis; // per owner
+    std::vector<unsigned> relax_stamp;
+    unsigned relax_round = 0;
+
+    void pivotRound(uniqueDistT B, const std::vector<int> &active, std::vector<int> &nw_active, std::vector<int> &vis, std::ofstream& log_file) {
+        const size_t nodes = adj.size();
+        auto &pool = parallel::default_pool();
+        const int T = std::max<size_t>(1, std::min<size_t>(pool.size(), active.size() / pivot_grain));
+        if(pivot_bucket.size() < (size_t)T * T) pivot_bucket.resize((size_t)T * T);
+        if(pivot_touched.size() < (size_t)T) pivot_touched.resize(T), pivot_new_vis.resize(T);
+        const unsigned round = nextStamp(relax_round, relax_stamp);
+        const auto owner = [&](int v) { return (int)((size_t)v * T / nodes); };
+
+        const auto collect = [&](int c) {
+            for(int o = 0; o < T; o++) pivot_bucket[(size_t)c * T + o].clear();
+            const size_t lo = active.size() * c / T, hi = active.size() * (c + 1) / T;
+            for(size_t i = lo; i < hi; i++) {
+                const int u = active[i];
                 for(auto [v, w]: adj[u]) {
-                    if(getDist(u, v, w) <= getDist(v)) {
-                        updateDist(u, v, w);
-                        if(getDist(v) < B) {
-                            root[v] = root[u];
-                            nw_active.push_back(v);
-                        }
+                    auto new_dist = getDist(u, v, w);
+                    if(new_dist <= getDist(v)) pivot_bucket[(size_t)c * T + owner(v)].push_back({new_dist, d[u] + w, root[u]});
+                }
+            }
+        };
+        const auto merge = [&](int o) {
+            auto &touched = pivot_touched[o];
+            auto &new_vis = pivot_new_vis[o];
+            touched.clear();
+            new_vis.clear();
+            for(int c = 0; c < T; c++) {
+                for(const auto &cand: pivot_bucket[(size_t)c * T + o]) {
+                    const int v = cand.dist.vertex();
+                    if(!(cand.dist <= getDist(v))) continue;
+                    pred[v] = cand.dist.pred;
+                    d[v] = cand.d;
+                    d_key[v] = cand.dist.dist;
+                    path_sz[v] = cand.dist.hops();
+                    if(cand.dist < B) root[v] = cand.root;
+                    if(relax_stamp[v] != round) {
+                        relax_stamp[v] = round;
+                        touched.push_back(v);
                     }
                 }
             }
-            for(const auto &x: nw_active) {
-                if(pivot_vis[x] != counter_pivot) {
-                    pivot_vis[x] = counter_pivot;
-                    if (log_file.is_open()) log_file << "W, " << x << '\n';
-                    vis.push_back(x);
+            // the final distance is the smallest accepted one, so it is below B iff some update was;
+            // sorted runs of contiguous owners concatenate to the same order for any T
+            std::sort(touched.begin(), touched.end());
+            size_t kept = 0;
+            for(int v: touched) {
+                if(!(getDist(v) < B)) continue;
+                touched[kept++] = v;
+                if(pivot_vis[v] != counter_pivot) {
+                    pivot_vis[v] = counter_pivot;
+                    new_vis.push_back(v);
                 }
             }
+            touched.resize(kept);
+        };
+        pool.run(T, collect);
+        pool.run(T, merge);
+
+        for(int o = 0; o < T; o++) {
+            nw_active.insert(nw_active.end(), pivot_touched[o].begin(), pivot_touched[o].end());
+            for(int x: pivot_new_vis[o]) {
+                if (log_file.is_open()) log_file << "W, " << x << '\n';
+                vis.push_back(x);
+            }
+        }
+    }
+
+    // Splits a call's wall time between its phases while profiling; free otherwise.
+    struct PhaseClock {
+        bool on;
+        std::chrono::steady_clock::time_point last;
+
+        explicit PhaseClock(bool on_): on(on_) {
+            if(on) last = std::chrono::steady_clock::now();
+        }
+        void charge(double &ms) {
+            if(!on) return;
+            const auto now = std::chrono::steady_clock::now();
+            ms += std::chrono::duration<double, std::milli>(now - last).count();
+            last = now;
+        }
+        void skip() {
+            if(on) last = std::chrono::steady_clock::now();
+        }
+    };
+
+    // Scratch of the call active at one level. The levels form a chain (a call at level l
+    // only calls level l - 1), so one frame per level suffices; its buffers are cleared,
+    // not freed, between calls and a warmed-up query allocates nothing here.
+    struct LevelFrame {
+        long long quota;
+        uniqueDistT B, trying_B, last_complete_B, retB;
+        const std::vector<int> *S;
+        std::vector<int> P, vis, active, nw_active; // findPivots
+        std::vector<int> pulled;                    // S of the call below
+        std::vector<int> complete;                  // U, read by the caller once this call returns
+        std::vector<uniqueDistT> can_prepend;
+        PhaseClock clock{false};
+    };
+    std::vector<LevelFrame> frames; // by level, 0 .. l
+    std::vector<int> source;        // S of the top call
+    BmsspLevelProfile profile_sink; // stands in for level_profile while profiling is off
+
+    void findPivots(LevelFrame &f, std::ofstream& log_file) { // Algorithm 1, fills f.P and f.vis
+        const std::vector<int> &S = *f.S;
+        nextStamp(counter_pivot, pivot_vis);
+
+        auto &vis = f.vis;
+        vis.clear();
+        for(int x: S) {
+            vis.push_back(x);
+            pivot_vis[x] = counter_pivot;
+        }
+
+        f.active.assign(S.begin(), S.end());
+        for(int x: S) root[x] = x, treesz[x] = 0;
+        for(int i = 1; i <= k; i++) {
+            f.nw_active.clear();
+            pivotRound(f.B, f.active, f.nw_active, vis, log_file);
             if(vis.size() > k * S.size()) {
-                return {S, vis};
+                f.P.assign(S.begin(), S.end());
+                return;
             }
-            active = move(nw_active);
+            std::swap(f.active, f.nw_active);
         }
 
-        std::vector<int> P;
-        P.reserve(vis.size() / k);
+        f.P.clear();
         for(int u: vis) treesz[root[u]]++;
         for(int u: S) if(treesz[u] >= k)
         {
             if (log_file.is_open()) log_file << "P, " << u << '\n';
-            P.push_back(u);
+            f.P.push_back(u);
         }
 
         // assert(P.size() <= vis.size() / k);
-        return {P, vis};
     }
 
-    std::pair<uniqueDistT, std::vector<int>> baseCase(uniqueDistT B, int x, std::ofstream& log_file) { // Algorithm 2
-        std::vector<int> complete;
-        complete.reserve(k + 1);
-
-        std::priority_queue<uniqueDistT, std::vector<uniqueDistT>, std::greater<uniqueDistT>> heap;
-        heap.push(getDist(x));
-        while(heap.empty() == false && complete.size() < k + 1) {
-            auto du = heap.top();
-            int u = get<2>(du);
-            heap.pop();
+    // Dijkstra from all of S below B, stopping once limit + 1 vertices are settled. With
+    // limit = k this is Algorithm 2 (seeded with all of S: the paper pulls singletons at
+    // level 1, a tuned M may pull more); with the level budget it is the hybrid leaf.
+    // Leaves the same (B', U) result as a recursive call in f.retB and f.complete.
+    std::vector<uniqueDistT> leaf_heap;
+    long long leaf_pushes = 0, leaf_pops = 0;
+    void boundedDijkstra(LevelFrame &f, long long limit, std::ofstream& log_file) {
+        const uniqueDistT B = f.B;
+        auto &complete = f.complete;
+        complete.clear();
+
+        const auto later = std::greater<uniqueDistT>();
+        auto &heap = leaf_heap;
+        heap.clear();
+        for(int x: *f.S) heap.push_back(getDist(x));
+        std::make_heap(heap.begin(), heap.end(), later);
+        leaf_pushes += f.S->size();
+        while(heap.empty() == false && (long long)complete.size() <= limit) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            leaf_pops++;
+            auto du = heap.back();
+            int u = du.vertex();
+            heap.pop_back();
 
             if(du > getDist(u)) continue;
 
@@ -695,85 +1095,250 @@ private:
                 auto new_dist = getDist(u, v, w);
                 auto old_dist = getDist(v);
                 if(new_dist <= old_dist && new_dist < B) {
-                    updateDist(u, v, w);
-                    heap.push(new_dist);
+                    updateDist(u, v, w, new_dist);
+                    heap.push_back(new_dist);
+                    std::push_heap(heap.begin(), heap.end(), later);
+                    leaf_pushes++;
                 }
             }
         }
-        if(complete.size() <= k) return {B, complete};
+        if((long long)complete.size() <= limit) {
+            f.retB = B;
+            return;
+        }
 
-        uniqueDistT nB = getDist(complete.back());
+        f.retB = getDist(complete.back());
         complete.pop_back();
-
-        return {nB, complete};
     }
 
+    BlockingHeapIndex heap_index;
     std::vector<BlockingBasedHeap<uniqueDistT>> Ds;
     std::vector<short int> last_complete_lvl;
-    std::pair<uniqueDistT, std::vector<int>> bmsspRec(short int l, uniqueDistT B, const std::vector<int> &S, std::ofstream& log_file) { // Algorithm 3
-        if(l == 0) return baseCase(B, S[0], log_file);
 
-        auto [P, bellman_vis] = findPivots(B, S, log_file);
+    BmsspLevelProfile &levelProfile(short int l) {
+        return profiling ? level_profile[l] : profile_sink;
+    }
+
+    // Algorithm 3, run with an explicit stack of frames rather than native recursion.
+    // frames[top] ends up holding the (B', U) of the top call.
+    void bmsspRec(short int top, uniqueDistT B, const std::vector<int> &S, std::ofstream& log_file) {
+        short int l = top;
+        bool returned = enterLevel(l, B, S, log_file);
+        while(true) {
+            if(returned) {
+                if(l == top) return;
+                l++;
+                absorbChild(l);
+            }
+            LevelFrame &f = frames[l];
+            auto &D = Ds[l - 1];
+            if((long long)f.complete.size() < f.quota && D.size()) {
+                f.trying_B = D.pull(f.pulled);
+                f.clock.charge(levelProfile(l).pull_ms);
+                // all with dist < trying_B, can be reached by pulled <= req 2, alg 3
+                returned = enterLevel(l - 1, f.trying_B, f.pulled, log_file);
+                l--;
+            } else {
+                finishLevel(l, log_file);
+                returned = true;
+            }
+        }
+    }
+
+    // Starts a call at level l. Returns true when its result is already final, as for
+    // the leaves; otherwise the call's heap has been filled from its pivots.
+    bool enterLevel(short int l, uniqueDistT B, const std::vector<int> &S, std::ofstream& log_file) {
+        LevelFrame &f = frames[l];
+        f.quota = k * (1ll << (l * t));
+        f.B = B;
+        f.S = &S;
+        if(l == 0 || f.quota <= hybrid_cutoff) {
+            const long long pushes = leaf_pushes, pops = leaf_pops;
+            const auto started = std::chrono::steady_clock::now();
+            boundedDijkstra(f, l == 0 ? k : f.quota, log_file);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+            if(l == 0) stats.base_case_ms += ms, stats.base_case_calls++;
+            else stats.hybrid_ms += ms, stats.hybrid_calls++;
+            if(profiling) {
+                BmsspLevelProfile &pr = level_profile[l];
+                pr.calls++;
+                pr.leaf_calls++;
+                pr.heap_pushes += leaf_pushes - pushes;
+                pr.heap_pops += leaf_pops - pops;
+                pr.leaf_ms += ms;
+            }
+            return true;
+        }
+
+        BmsspLevelProfile &pr = levelProfile(l);
+        f.clock = PhaseClock(profiling);
+
+        findPivots(f, log_file);
+        pr.calls++;
+        pr.pivot_sources += S.size();
+        pr.pivots += f.P.size();
+        pr.pivot_visited += f.vis.size();
+        f.clock.charge(pr.pivot_ms);
 
-        const long long batch_size = (1ll << ((l - 1) * t));
         auto &D = Ds[l - 1];
-        D.initialize(batch_size, B);
-        for(int p: P) D.insert(getDist(p));
-
-        uniqueDistT last_complete_B = B;
-        for(int p: P) last_complete_B = std::min(last_complete_B, getDist(p));
-
-        std::vector<int> complete;
-        const long long quota = k * (1ll << (l * t));
-        complete.reserve(quota + bellman_vis.size());
-        while(complete.size() < quota && D.size()) {
-            auto [trying_B, miniS] = D.pull();
-            // all with dist < trying_B, can be reached by miniS <= req 2, alg 3
-            auto [complete_B, nw_complete] = bmsspRec(l - 1, trying_B, miniS, log_file);
-
-            // all new complete_B are greater than the old ones <= point 6, page 10
-            // assert(last_complete_B < complete_B);
-
-            complete.insert(complete.end(), nw_complete.begin(), nw_complete.end());
-            // point 6, page 10 => complete does not intersect with nw_complete
-            // assert(isUnique(complete));
-
-            std::vector<uniqueDistT> can_prepend;
-            can_prepend.reserve(nw_complete.size() * 5 + miniS.size());
-            for(int u: nw_complete) {
-                D.erase(u); // priority queue fix
-                last_complete_lvl[u] = l;
-                for(auto [v, w]: adj[u]) {
-                    auto new_dist = getDist(u, v, w);
-                    if(new_dist <= getDist(v)) {
-                        updateDist(u, v, w);
-                        if(trying_B <= new_dist && new_dist < B) {
-                            D.insert(new_dist); // d[v] can be greater equal than std::min(D), occur 1x per vertex
-                        } else if(complete_B <= new_dist && new_dist < trying_B) {
-                            can_prepend.emplace_back(new_dist); // d[v] is less than all in D, can occur 1x at each level per vertex
-                        }
+        D.initialize(block_size[l - 1], B);
+        for(int p: f.P) D.insert(getDist(p));
+
+        f.last_complete_B = B;
+        for(int p: f.P) f.last_complete_B = std::min(f.last_complete_B, getDist(p));
+
+        f.complete.clear();
+        f.clock.charge(pr.relax_ms);
+        return false;
+    }
+
+    // Takes in the result of the call at level l - 1 just made from level l.
+    void absorbChild(short int l) {
+        LevelFrame &f = frames[l];
+        const LevelFrame &child = frames[l - 1];
+        BmsspLevelProfile &pr = levelProfile(l);
+        auto &D = Ds[l - 1];
+        f.clock.skip(); // charged to the level below
+
+        const uniqueDistT trying_B = f.trying_B, complete_B = child.retB, B = f.B;
+        const std::vector<int> &nw_complete = child.complete;
+
+        // all new complete_B are greater than the old ones <= point 6, page 10
+        // assert(last_complete_B < complete_B);
+
+        f.complete.insert(f.complete.end(), nw_complete.begin(), nw_complete.end());
+        // point 6, page 10 => complete does not intersect with nw_complete
+        // assert(isUnique(complete));
+
+        auto &can_prepend = f.can_prepend;
+        can_prepend.clear();
+        for(int u: nw_complete) {
+            D.erase(u); // priority queue fix
+            last_complete_lvl[u] = l;
+            for(auto [v, w]: adj[u]) {
+                auto new_dist = getDist(u, v, w);
+                if(new_dist <= getDist(v)) {
+                    updateDist(u, v, w, new_dist);
+                    if(trying_B <= new_dist && new_dist < B) {
+                        D.insert(new_dist); // d[v] can be greater equal than std::min(D), occur 1x per vertex
+                    } else if(complete_B <= new_dist && new_dist < trying_B) {
+                        can_prepend.emplace_back(new_dist); // d[v] is less than all in D, can occur 1x at each level per vertex
                     }
                 }
             }
-            for(int x: miniS) {
-                if(complete_B <= getDist(x)) can_prepend.emplace_back(getDist(x));
-                // second condition is not necessary
-            }
-            // can_prepend is not necessarily all unique
-            D.batchPrepend(can_prepend);
-
-            last_complete_B = complete_B;
         }
-        uniqueDistT retB;
-        if(D.size() == 0) retB = B;     // successful
-        else retB = last_complete_B;    // partial
+        for(int x: f.pulled) {
+            if(complete_B <= getDist(x)) can_prepend.emplace_back(getDist(x));
+            // second condition is not necessary
+        }
+        f.clock.charge(pr.relax_ms);
+        // can_prepend is not necessarily all unique
+        D.batchPrepend(can_prepend);
+        f.clock.charge(pr.prepend_ms);
 
-        for(int x: bellman_vis) if(last_complete_lvl[x] != l && getDist(x) < retB) {
+        f.last_complete_B = complete_B;
+    }
+
+    // Ends the call at level l once its quota is met or its heap is empty.
+    void finishLevel(short int l, std::ofstream& log_file) {
+        LevelFrame &f = frames[l];
+        if(Ds[l - 1].size() == 0) f.retB = f.B; // successful
+        else f.retB = f.last_complete_B;        // partial
+
+        for(int x: f.vis) if(last_complete_lvl[x] != l && getDist(x) < f.retB) {
             if (log_file.is_open()) log_file << "U, " << x << '\n';
-            complete.push_back(x); // this get the completed vertices from bellman-ford, it has P in it as well
+            f.complete.push_back(x); // this get the completed vertices from bellman-ford, it has P in it as well
         }
+        f.clock.charge(levelProfile(l).relax_ms);
         // get only the ones not in complete already, for it to become disjoint
-        return {retB, complete};
+    }
+};
+
+// Prepares a graph and answers queries with one context, as a single object. To query
+// one graph from several threads, share prepared() and give each its own context.
+template<typename wT>
+class bmssp { // bmssp class
+    int n;
+    BmsspParams params;
+
+    std::vector<std::vector<std::pair<int, wT>>> ori_adj;
+    const Graph *source = nullptr; // read in place by prepare_graph() instead of ori_adj
+    std::shared_ptr<const BmsspPreparedGraph<wT>> graph;
+    std::unique_ptr<BmsspQueryContext<wT>> ctx;
+
+public:
+    using QueryView = typename BmsspQueryContext<wT>::QueryView;
+
+    const wT oo = INF;
+    bmssp(int n_): n(n_) {
+        ori_adj.assign(n, {});
+    }
+    bmssp(const auto &adj) {
+        n = adj.size();
+        ori_adj = adj;
+    }
+    // Read-only view: no edge is copied before prepare_graph(), which must run while
+    // the graph is alive. Afterwards the solver no longer refers to it.
+    explicit bmssp(const Graph &graph): n(graph.size()), source(&graph) {}
+
+    void addEdge(int a, int b, wT w) {
+        ori_adj[a].emplace_back(b, w);
+    }
+
+    // takes effect at the next prepare_graph()
+    void set_params(const BmsspParams &p) {
+        params = p;
+    }
+
+    // if the graph already has constant degree, prepage_graph(false)
+    // else, prepage_graph(true)
+    void prepare_graph(bool exec_constant_degree_trasnformation = false) {
+        ctx.reset();
+        if(source) graph = BmsspPreparedGraph<wT>::build(source->adj, n, exec_constant_degree_trasnformation, params);
+        else graph = BmsspPreparedGraph<wT>::build(ori_adj, n, exec_constant_degree_trasnformation, params);
+        ori_adj = {};
+        source = nullptr;
+        ctx = std::make_unique<BmsspQueryContext<wT>>(graph);
+    }
+
+    std::shared_ptr<const BmsspPreparedGraph<wT>> prepared() const {
+        return graph;
+    }
+
+    BmsspQueryContext<wT> &context() {
+        return *ctx;
+    }
+
+    BmsspParams effective_params() const {
+        return graph->effective_params();
+    }
+
+    const BmsspStats &get_stats() const {
+        return ctx->get_stats();
+    }
+
+    void reset_stats() {
+        ctx->reset_stats();
+    }
+
+    std::vector<BmsspLevelProfile> get_profile() const {
+        return ctx->get_profile();
+    }
+
+    QueryView query(int s) {
+        return ctx->query(s);
+    }
+
+    void execute_into(int s, std::span<wT> dist, std::span<int> real_pred) {
+        ctx->execute_into(s, dist, real_pred);
+    }
+
+    std::pair<std::vector<wT>, std::vector<int>> execute(int s) {
+        return ctx->execute(s);
+    }
+
+    std::vector<int> get_shortest_path(int real_u, std::span<const int> real_pred) {
+        return ctx->get_shortest_path(real_u, real_pred);
     }
 };
 
@@ -0,0 +1,19 @@
+#ifndef SMALLCPPPROGRAM_BMSSP_PARAMS_H
+#define SMALLCPPPROGRAM_BMSSP_PARAMS_H
+
+#include <vector>
+
+// Tuning knobs of bmssp; zero / empty fields keep the defaults of the paper:
+// k = floor(log2(N)^(1/3)), t = floor(log2(N)^(2/3)) and M = 2^((level - 1) * t).
+struct BmsspParams {
+    int k = 0;
+    int t = 0;
+    double block_scale = 1.0;            // multiplies the default M of every level
+    std::vector<long long> block_sizes;  // explicit M for levels 1, 2, ...; overrides block_scale
+    // sub-problems whose budget k * 2^(l * t) is at most this run a bounded Dijkstra
+    // instead of recursing; 0 turns the hybrid off, -1 (auto) hands over levels 1 and 2
+    long long hybrid_cutoff = 0;
+    bool profile = false; // collect BmsspLevelProfile rows; adds clock reads to every call
+};
+
+#endif
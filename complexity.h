@@ -0,0 +1,153 @@
+#ifndef SMALLCPPPROGRAM_COMPLEXITY_H
+#define SMALLCPPPROGRAM_COMPLEXITY_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Growth models fitted to the times of a sweep, and where two fitted algorithms cross.
+namespace complexity {
+
+// power_n and power_m fit the exponent; the others only a constant factor of a fixed shape.
+enum Model { PowerN, PowerM, NLogN, MLogN, MLog23N, NM, ModelCount };
+
+inline const char* model_name(const int model) {
+    static const char* const names[ModelCount] = {"n^b", "m^b", "n*log(n)", "m*log(n)", "m*log(n)^(2/3)", "n*m"};
+    return names[model];
+}
+
+struct Point {
+    double n;  // vertices
+    double m;  // edges
+    double ms; // measured time
+};
+
+// time = coefficient * shape(n, m), or coefficient * x^exponent for the power laws.
+struct Fit {
+    Model model = PowerN;
+    bool valid = false;
+    int points = 0;
+    double coefficient = 0.0;
+    double exponent = 1.0;
+    double rms_log = 0.0; // root mean square of log(measured / fitted)
+    double r2 = 0.0;      // of log time
+};
+
+// log2 clamped at 1, so tiny graphs do not send the shapes to zero.
+inline double log_n(const double n) { return std::max(1.0, std::log2(std::max(n, 1.0))); }
+
+inline double shape(const Model model, const double n, const double m) {
+    switch (model) {
+        case NLogN: return n * log_n(n);
+        case MLogN: return m * log_n(n);
+        case MLog23N: return m * std::pow(log_n(n), 2.0 / 3.0);
+        case NM: return n * m;
+        default: return 1.0;
+    }
+}
+
+inline double predict(const Fit& fit, const double n, const double m) {
+    switch (fit.model) {
+        case PowerN: return fit.coefficient * std::pow(n, fit.exponent);
+        case PowerM: return fit.coefficient * std::pow(m, fit.exponent);
+        default: return fit.coefficient * shape(fit.model, n, m);
+    }
+}
+
+/**
+ * @brief Least-squares fit in log space, so every sweep point weighs the same
+ * relative error whatever its size.
+ *
+ * Power laws regress log time on log n (or log m); the fixed shapes only fit
+ * log coefficient = mean(log time - log shape). Points with non-positive values
+ * are ignored, and a power law needs at least two distinct sizes.
+ */
+inline Fit fit(const Model model, const std::vector<Point>& points) {
+    Fit f;
+    f.model = model;
+    std::vector<double> xs, ys;
+    for (const Point& p : points) {
+        if (p.ms <= 0 || p.n <= 0 || p.m <= 0) continue;
+        ys.push_back(std::log(p.ms));
+        xs.push_back(model == PowerN ? std::log(p.n) : model == PowerM ? std::log(p.m) : std::log(shape(model, p.n, p.m)));
+    }
+    const size_t k = ys.size();
+    if (k == 0) return f;
+    f.points = static_cast<int>(k);
+
+    double mean_x = 0, mean_y = 0;
+    for (size_t i = 0; i < k; ++i) {
+        mean_x += xs[i] / k;
+        mean_y += ys[i] / k;
+    }
+    double intercept, slope = 1.0;
+    if (model == PowerN || model == PowerM) {
+        double sxx = 0, sxy = 0;
+        for (size_t i = 0; i < k; ++i) {
+            sxx += (xs[i] - mean_x) * (xs[i] - mean_x);
+            sxy += (xs[i] - mean_x) * (ys[i] - mean_y);
+        }
+        if (k < 2 || sxx <= 1e-12) return f;
+        slope = sxy / sxx;
+    }
+    intercept = mean_y - slope * mean_x;
+
+    double ss_res = 0, ss_tot = 0;
+    for (size_t i = 0; i < k; ++i) {
+        const double r = ys[i] - (intercept + slope * xs[i]);
+        ss_res += r * r;
+        ss_tot += (ys[i] - mean_y) * (ys[i] - mean_y);
+    }
+    f.valid = true;
+    f.coefficient = std::exp(intercept);
+    f.exponent = slope;
+    f.rms_log = std::sqrt(ss_res / k);
+    f.r2 = ss_tot > 0 ? 1.0 - ss_res / ss_tot : 1.0;
+    return f;
+}
+
+// How the sweep grows edges with vertices, m = k * n^e, for extrapolating m-based fits.
+struct Growth {
+    double k = 1.0;
+    double e = 1.0;
+};
+
+inline Growth edge_growth(const std::vector<Point>& points) {
+    std::vector<Point> as_time;
+    for (const Point& p : points) as_time.push_back({p.n, 1.0, p.m});
+    const Fit f = fit(PowerN, as_time);
+    return f.valid ? Growth{f.coefficient, f.exponent} : Growth{};
+}
+
+/**
+ * @brief Smallest n above `from` where the predictions of a and b swap order, 0 when
+ * they do not within `limit`.
+ *
+ * Scans log10 n in steps of 0.01 and refines the sign change by bisection.
+ */
+inline double crossover(const Fit& a, const Fit& b, const Growth& growth, const double from, const double limit = 1e15) {
+    const auto gap = [&](const double log10_n) {
+        const double n = std::pow(10.0, log10_n);
+        const double m = growth.k * std::pow(n, growth.e);
+        return std::log(predict(a, n, m)) - std::log(predict(b, n, m));
+    };
+    const double start = std::log10(std::max(from, 1.0)), end = std::log10(limit);
+    double lo = start, g_lo = gap(lo);
+    for (double hi = start + 0.01; hi <= end + 1e-9; hi += 0.01) {
+        const double g_hi = gap(hi);
+        if ((g_lo < 0) != (g_hi < 0)) {
+            for (int i = 0; i < 50; ++i) {
+                const double mid = (lo + hi) / 2;
+                ((gap(mid) < 0) == (g_lo < 0) ? lo : hi) = mid;
+            }
+            return std::pow(10.0, (lo + hi) / 2);
+        }
+        lo = hi;
+        g_lo = g_hi;
+    }
+    return 0.0;
+}
+
+} // namespace complexity
+
+#endif //SMALLCPPPROGRAM_COMPLEXITY_H
@@ -1,7 +1,9 @@
 #include "config.h"
 #include "graph_generators.h"
+#include "graph_utils.h"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 using namespace simple_yaml;
 
@@ -94,16 +96,73 @@ static generators::ConnectivityType parse_connectivity_type(const std::string& s
     throw std::runtime_error("Unknown connectivity_type: " + s);
 }
 
-static std::vector<int> parse_int_list(const Node& node) {
-    std::vector<int> result;
+template <typename T>
+static std::vector<T> parse_list(const Node& node) {
+    std::vector<T> result;
     if (node.IsSequence()) {
-        for (auto& v : node.seq_items()) result.push_back(v.as<int>());
+        for (auto& v : node.seq_items()) result.push_back(v.as<T>());
     } else {
-        result.push_back(node.as<int>());
+        result.push_back(node.as<T>());
     }
     return result;
 }
 
+// Names from phase_name(); the listed phases make up the headline time.
+static std::array<bool, kPhaseCount> parse_headline(const Node& node) {
+    std::array<bool, kPhaseCount> headline{};
+    for (const auto& name : parse_list<std::string>(node)) {
+        int p = 0;
+        while (p < kPhaseCount && name != phase_name(static_cast<Phase>(p))) ++p;
+        if (p == kPhaseCount) throw std::runtime_error("Unknown benchmark phase: " + name);
+        headline[p] = true;
+    }
+    return headline;
+}
+
+// `sources: [0, 7]` lists them; `sources: { mode: random, count: 16, seed: 3 }` draws them.
+static SourceConfig parse_sources(const Node& node) {
+    SourceConfig sources;
+    if (node.IsSequence()) {
+        sources.mode = "list";
+        sources.list = parse_list<int>(node);
+        return sources;
+    }
+    sources.mode = node["mode"].as<std::string>();
+    if (sources.mode != "random" && sources.mode != "degree" && sources.mode != "eccentricity") {
+        throw std::runtime_error("Unknown sources mode: " + sources.mode);
+    }
+    if (node.has("count")) sources.count = node["count"].as<int>();
+    if (node.has("seed")) sources.seed = static_cast<unsigned>(node["seed"].as<long long>());
+    return sources;
+}
+
+// `validate: true`, or `validate: { triangle: true, tolerance: 1e-9 }`.
+static void parse_validate(const Node& node, BenchmarkConfig& bm) {
+    if (!node.IsMap()) {
+        bm.validate = node.as<bool>();
+        return;
+    }
+    bm.validate = true;
+    bm.validate_triangle = node.has("triangle") && node["triangle"].as<bool>();
+    if (node.has("tolerance")) bm.validate_tolerance = node["tolerance"].as<double>();
+}
+
+static long long parse_hybrid_cutoff(const Node& node) {
+    const auto cutoff = node.as<std::string>();
+    return cutoff == "auto" ? -1 : std::stoll(cutoff);
+}
+
+static BmsspParams parse_bmssp_params(const Node& node) {
+    BmsspParams p;
+    if (node.has("k")) p.k = node["k"].as<int>();
+    if (node.has("t")) p.t = node["t"].as<int>();
+    if (node.has("block_scale")) p.block_scale = node["block_scale"].as<double>();
+    if (node.has("block_sizes")) p.block_sizes = parse_list<long long>(node["block_sizes"]);
+    if (node.has("hybrid_cutoff")) p.hybrid_cutoff = parse_hybrid_cutoff(node["hybrid_cutoff"]);
+    if (node.has("profile")) p.profile = node["profile"].as<bool>();
+    return p;
+}
+
 static Graph create_graph(const std::string& type, const Node& params) {
     bool directed = params.has("directed") ? params["directed"].as<bool>() : true;
 
@@ -143,7 +202,7 @@ static Graph create_graph(const std::string& type, const Node& params) {
         return generators::gen_hexagonal_lattice(rows, cols, directed);
     }
     if (type == "k_partite") {
-        auto sizes = parse_int_list(params["partition_sizes"]);
+        auto sizes = parse_list<int>(params["partition_sizes"]);
         double prob = params.has("edge_probability") ? params["edge_probability"].as<double>() : 1.0;
         return generators::gen_k_partite(sizes, prob, directed);
     }
@@ -200,6 +259,10 @@ Config parse_config(const std::string& filename) {
             AlgorithmConfig algo;
             algo.name = algo_node["name"].as<std::string>();
             algo.start_node = algo_node.has("start_node") ? algo_node["start_node"].as<int>() : 0;
+            algo.log = algo_node.has("log") && algo_node["log"].as<bool>();
+            if (algo_node.has("timeout_s")) algo.timeout_s = algo_node["timeout_s"].as<double>();
+            if (algo_node.has("memory_mb")) algo.memory_mb = algo_node["memory_mb"].as<long long>();
+            if (algo.name == "bmssp") algo.bmssp = parse_bmssp_params(algo_node);
             exp.algorithms.push_back(algo);
         }
 
@@ -207,11 +270,58 @@ Config parse_config(const std::string& filename) {
             auto& bm = exp_node["benchmark"];
             exp.benchmark.iterations = bm.has("iterations") ? bm["iterations"].as<int>() : 5;
             exp.benchmark.warmup = bm.has("warmup") ? bm["warmup"].as<int>() : 2;
+            exp.benchmark.counters = bm.has("counters") && bm["counters"].as<bool>();
+            exp.benchmark.memory = bm.has("memory") && bm["memory"].as<bool>();
+            exp.benchmark.reject_outliers = bm.has("reject_outliers") && bm["reject_outliers"].as<bool>();
+            exp.benchmark.record_samples = bm.has("record_samples") && bm["record_samples"].as<bool>();
+            if (bm.has("target_ci")) exp.benchmark.target_ci = bm["target_ci"].as<double>();
+            if (bm.has("time_budget_ms")) exp.benchmark.time_budget_ms = bm["time_budget_ms"].as<double>();
+            if (bm.has("max_iterations")) exp.benchmark.max_iterations = bm["max_iterations"].as<int>();
+            if (bm.has("headline")) exp.benchmark.headline = parse_headline(bm["headline"]);
+            if (bm.has("sources")) exp.benchmark.sources = parse_sources(bm["sources"]);
+            if (bm.has("validate")) parse_validate(bm["validate"], exp.benchmark);
+            exp.benchmark.isolate = bm.has("isolate") && bm["isolate"].as<bool>();
+            if (bm.has("timeout_s")) exp.benchmark.timeout_s = bm["timeout_s"].as<double>();
+            if (bm.has("memory_mb")) exp.benchmark.memory_mb = bm["memory_mb"].as<long long>();
+            exp.benchmark.skip_larger = bm.has("skip_larger") && bm["skip_larger"].as<bool>();
         }
 
         config.experiments.push_back(exp);
     }
 
+    if (root.has("profile_output")) config.profile_output = root["profile_output"].as<std::string>();
+    if (root.has("samples_output")) config.samples_output = root["samples_output"].as<std::string>();
+    if (root.has("json_output")) config.json_output = root["json_output"].as<std::string>();
+    if (root.has("csv_output")) config.csv_output = root["csv_output"].as<std::string>();
+    if (root.has("complexity_output")) config.complexity_output = root["complexity_output"].as<std::string>();
+
+    if (root.has("runner")) {
+        auto& run = root["runner"];
+        if (run.has("jobs")) config.runner.jobs = std::max(0, run["jobs"].as<int>());
+        config.runner.pin = run.has("pin") && run["pin"].as<bool>();
+        config.runner.physical_cores = run.has("physical_cores") && run["physical_cores"].as<bool>();
+        config.runner.numa_local = run.has("numa_local") && run["numa_local"].as<bool>();
+    }
+
+    if (root.has("autotune")) {
+        auto& at = root["autotune"];
+        auto& tune = config.autotune;
+        if (at.has("samples")) tune.samples = at["samples"].as<int>();
+        if (at.has("iterations")) tune.iterations = at["iterations"].as<int>();
+        if (at.has("warmup")) tune.warmup = at["warmup"].as<int>();
+        if (at.has("k")) tune.k = parse_list<int>(at["k"]);
+        if (at.has("t")) tune.t = parse_list<int>(at["t"]);
+        if (at.has("block_scale")) tune.block_scale = parse_list<double>(at["block_scale"]);
+        if (at.has("hybrid_cutoff")) {
+            tune.hybrid_cutoff.clear();
+            if (at["hybrid_cutoff"].IsSequence()) {
+                for (auto& v : at["hybrid_cutoff"].seq_items()) tune.hybrid_cutoff.push_back(parse_hybrid_cutoff(v));
+            } else {
+                tune.hybrid_cutoff.push_back(parse_hybrid_cutoff(at["hybrid_cutoff"]));
+            }
+        }
+    }
+
     return config;
 }
 
@@ -224,3 +334,30 @@ std::vector<Graph> generate_graphs_for_experiment(const ExperimentConfig& exp) {
     }
     return graphs;
 }
+
+std::vector<Graph> sample_graphs_for_experiment(const ExperimentConfig& exp, int count) {
+    auto param_sets = expand_sweep_params(exp.params, exp.sweep);
+    const size_t total = param_sets.size();
+    const size_t take = std::min<size_t>(total, std::max(count, 1));
+    std::vector<Graph> graphs;
+    graphs.reserve(take);
+    for (size_t i = 0; i < take; ++i) {
+        const size_t idx = take == 1 ? total - 1 : i * (total - 1) / (take - 1);
+        graphs.push_back(create_graph(exp.generator_type, param_sets[idx]));
+    }
+    return graphs;
+}
+
+std::vector<int> select_sources(const ExperimentConfig& exp, const Graph& graph) {
+    const SourceConfig& cfg = exp.benchmark.sources;
+    if (cfg.mode.empty()) return {};
+    if (cfg.mode == "list") {
+        for (int s : cfg.list) {
+            if (s < 0 || s >= graph.size()) throw std::runtime_error("Source " + std::to_string(s) + " is not a vertex");
+        }
+        return cfg.list;
+    }
+    if (cfg.mode == "random") return graph_utils::random_sources(graph, cfg.count, cfg.seed);
+    const auto by = cfg.mode == "degree" ? graph_utils::SourceStrata::Degree : graph_utils::SourceStrata::Eccentricity;
+    return graph_utils::stratified_sources(graph, cfg.count, by, cfg.seed);
+}
@@ -1,19 +1,55 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <array>
 #include <string>
 #include <vector>
 #include "simple_yaml.h"
 #include "graph_types.h"
+#include "benchmark_options.h"
+#include "bmssp_params.h"
+#include "runner_options.h"
 
 struct AlgorithmConfig {
     std::string name;
     int start_node = 0;
+    BmsspParams bmssp; // k, t, block_scale, block_sizes keys of a bmssp entry
+    bool log = false;  // write the trace (dijkstra.log, bmssp.log) while measuring, its cost included
+    double timeout_s = -1;   // budgets of this algorithm, -1 takes the benchmark block's
+    long long memory_mb = -1;
+};
+
+// Sources every algorithm of an experiment is run from, the same set for each; with no
+// mode every algorithm uses its own start_node.
+struct SourceConfig {
+    std::string mode; // list, random, degree or eccentricity (the last two stratified)
+    std::vector<int> list;
+    int count = 8;
+    unsigned seed = 1;
 };
 
 struct BenchmarkConfig {
     int iterations = 5;
     int warmup = 2;
+    bool counters = false; // hardware counters around each iteration, see perf_counters.h
+    bool memory = false;   // allocations and peak RSS of setup and each iteration, see memory_stats.h
+    bool reject_outliers = false; // statistics without the samples the MAD rule flags
+    bool record_samples = false;  // every iteration's time to Config::samples_output
+    // adaptive mode, on when either is set: iterations is then the minimum, see AdaptiveStop
+    double target_ci = 0.0;       // relative width of the median's 95% interval
+    double time_budget_ms = 0.0;
+    int max_iterations = 1000;
+    std::array<bool, kPhaseCount> headline{false, true, true, true}; // phases in the timing columns
+    SourceConfig sources;
+    // untimed re-run from every source, checksummed against the experiment's first algorithm, see validation.h
+    bool validate = false;
+    bool validate_triangle = false;     // also verify every edge against the distances
+    double validate_tolerance = 1e-9;   // relative
+    // each job in a forked child, see isolation.h; a time or memory budget turns it on
+    bool isolate = false;
+    double timeout_s = 0;     // per job: warmup, measurement and validation
+    long long memory_mb = 0;
+    bool skip_larger = false; // after a timeout or OOM, skip the algorithm on graphs at least as large
 };
 
 struct ExperimentConfig {
@@ -25,12 +61,36 @@ struct ExperimentConfig {
     BenchmarkConfig benchmark;
 };
 
+// Search space of --autotune; every combination of k, t, block_scale and hybrid_cutoff is timed.
+struct AutotuneConfig {
+    int samples = 3;   // graphs taken from each experiment's sweep, spread evenly
+    int iterations = 3;
+    int warmup = 1;
+    std::vector<int> k{1, 2, 3, 4};
+    std::vector<int> t{1, 2, 3, 4, 6, 8};
+    std::vector<double> block_scale{0.25, 1.0, 4.0};
+    std::vector<long long> hybrid_cutoff{0, -1}; // -1 is auto
+};
+
 struct Config {
     std::vector<ExperimentConfig> experiments;
+    AutotuneConfig autotune;
+    std::string profile_output = "bmssp_profile.tsv"; // rows of bmssp entries with profile: true
+    std::string samples_output = "benchmark_samples.tsv"; // rows of experiments with record_samples: true
+    std::string json_output; // results with environment metadata, off when empty (see results.h)
+    std::string csv_output;
+    std::string complexity_output; // growth-model fits of every sweep, off when empty (see complexity.h)
+    runner::Options runner; // how many (graph, algorithm) jobs run at once, and where
 };
 
 Config parse_config(const std::string& filename);
 
 std::vector<Graph> generate_graphs_for_experiment(const ExperimentConfig& exp);
 
+// At most `count` graphs of the sweep, evenly spread and always including the last one.
+std::vector<Graph> sample_graphs_for_experiment(const ExperimentConfig& exp, int count);
+
+// The experiment's source set on this graph; empty when each algorithm keeps its start_node.
+std::vector<int> select_sources(const ExperimentConfig& exp, const Graph& graph);
+
 #endif
@@ -17,9 +17,13 @@ inline std::vector<double> dijkstra(const Graph& graph, const int start, const s
 
     if (n == 0) return dist;
 
-    std::ofstream log_file(log_filename);
-    if (!log_file.is_open()) {
-        std::cout << "Failed to open dijkstra.log file!";
+    // an empty log_filename turns logging off
+    std::ofstream log_file;
+    if (!log_filename.empty()) {
+        log_file.open(log_filename);
+        if (!log_file.is_open()) {
+            std::cout << "Failed to open dijkstra.log file!";
+        }
     }
 
     dist[start] = 0;
@@ -1,8 +1,11 @@
 #ifndef GRAPH_TYPES_H
 #define GRAPH_TYPES_H
 
-#include <vector>
+#include <cstddef>
+#include <ranges>
 #include <string>
+#include <tuple>
+#include <vector>
 
 struct Edge {
     int to;
@@ -22,20 +25,58 @@ public:
         adj[u].emplace_back(v, weight);
     }
 
-    [[nodiscard]] std::vector<std::tuple<int, int, double>> edges() const
-    {
-        auto result = std::vector<std::tuple<int, int, double>> { };
-        int i = 0;
-        for (const auto& item : adj)
-        {
-            for (auto edge : item)
-            {
-                result.emplace_back(i, edge.to, edge.weight);
+    // Lazy view over every edge as a (from, to, weight) tuple, in adjacency order.
+    class EdgeView : public std::ranges::view_interface<EdgeView> {
+    public:
+        class iterator {
+        public:
+            using value_type = std::tuple<int, int, double>;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            iterator(const std::vector<std::vector<Edge>>* adj, const int u) : adj_(adj), u_(u) { skip_empty(); }
+
+            value_type operator*() const {
+                const Edge& edge = (*adj_)[u_][i_];
+                return {u_, edge.to, edge.weight};
             }
-            i += 1;
-        }
-        return result;
-    }
+            iterator& operator++() {
+                if (++i_ == (*adj_)[u_].size()) {
+                    ++u_;
+                    i_ = 0;
+                    skip_empty();
+                }
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator old = *this;
+                ++*this;
+                return old;
+            }
+            bool operator==(const iterator& other) const { return u_ == other.u_ && i_ == other.i_; }
+
+        private:
+            void skip_empty() {
+                while (u_ < static_cast<int>(adj_->size()) && (*adj_)[u_].empty()) ++u_;
+            }
+
+            const std::vector<std::vector<Edge>>* adj_ = nullptr;
+            int u_ = 0;
+            size_t i_ = 0;
+        };
+
+        EdgeView() = default;
+        explicit EdgeView(const std::vector<std::vector<Edge>>& adj) : adj_(&adj) { }
+
+        // a default-constructed view is empty
+        [[nodiscard]] iterator begin() const { return adj_ ? iterator(adj_, 0) : iterator(); }
+        [[nodiscard]] iterator end() const { return adj_ ? iterator(adj_, static_cast<int>(adj_->size())) : iterator(); }
+
+    private:
+        const std::vector<std::vector<Edge>>* adj_ = nullptr;
+    };
+
+    [[nodiscard]] EdgeView edges() const { return EdgeView(adj); }
 
     [[nodiscard]] int size() const { return n; }
 };
@@ -5,6 +5,9 @@
 #include <iomanip>
 #include <cmath>
 #include <limits>
+#include <algorithm>
+#include <numeric>
+#include <random>
 
 namespace graph_utils {
     const double INF_WEIGHT = std::numeric_limits<double>::infinity();
@@ -64,4 +67,80 @@ namespace graph_utils {
         const auto matrix = to_adjacency_matrix(graph);
         return save_matrix_to_file(matrix, filename, infinity_symbol);
     }
+
+    std::vector<int> random_sources(const Graph& graph, const int count, const unsigned seed) {
+        std::vector<int> vertices(graph.size());
+        std::iota(vertices.begin(), vertices.end(), 0);
+        std::mt19937 rng(seed);
+        const int take = std::min(count, graph.size());
+        for (int i = 0; i < take; ++i) { // partial Fisher-Yates
+            std::uniform_int_distribution<int> pick(i, graph.size() - 1);
+            std::swap(vertices[i], vertices[pick(rng)]);
+        }
+        vertices.resize(std::max(take, 0));
+        return vertices;
+    }
+
+    std::vector<int> stratified_sources(const Graph& graph, const int count, const SourceStrata by, const unsigned seed) {
+        const int n = graph.size();
+        std::vector<int> key(n);
+        if (by == SourceStrata::Degree) {
+            for (int v = 0; v < n; ++v) key[v] = static_cast<int>(graph.adj[v].size());
+        } else {
+            key = estimate_eccentricity(graph);
+        }
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) { return key[a] < key[b]; });
+
+        std::mt19937 rng(seed);
+        const int strata = std::min(count, n);
+        std::vector<int> sources;
+        for (int s = 0; s < strata; ++s) {
+            const long long lo = static_cast<long long>(n) * s / strata, hi = static_cast<long long>(n) * (s + 1) / strata;
+            std::uniform_int_distribution<long long> pick(lo, hi - 1);
+            sources.push_back(order[pick(rng)]);
+        }
+        return sources;
+    }
+
+    std::vector<int> estimate_eccentricity(const Graph& graph) {
+        const int n = graph.size();
+        std::vector<std::vector<int>> undirected(n);
+        for (int u = 0; u < n; ++u) {
+            for (const auto& edge : graph.adj[u]) {
+                undirected[u].push_back(edge.to);
+                undirected[edge.to].push_back(u);
+            }
+        }
+
+        // hop distances from `from`; returns the farthest vertex, visiting only its component
+        std::vector<int> queue;
+        const auto bfs = [&](const int from, std::vector<int>& dist) {
+            queue.assign(1, from);
+            dist[from] = 0;
+            int farthest = from;
+            for (size_t head = 0; head < queue.size(); ++head) {
+                const int u = queue[head];
+                if (dist[u] > dist[farthest]) farthest = u;
+                for (const int v : undirected[u]) {
+                    if (dist[v] < 0) {
+                        dist[v] = dist[u] + 1;
+                        queue.push_back(v);
+                    }
+                }
+            }
+            return farthest;
+        };
+
+        std::vector<int> ecc(n, -1), dist_r(n, -1), dist_a(n, -1), dist_b(n, -1);
+        for (int r = 0; r < n; ++r) {
+            if (ecc[r] >= 0) continue;
+            const int a = bfs(r, dist_r);
+            const int b = bfs(a, dist_a);
+            bfs(b, dist_b);
+            for (const int v : queue) ecc[v] = std::max(dist_a[v], dist_b[v]); // queue holds the component
+        }
+        return ecc;
+    }
 } // namespace graph_utils
\ No newline at end of file
@@ -25,6 +25,21 @@ namespace graph_utils {
         const Graph& graph,
         const std::string& filename,
         const std::string& infinity_symbol = "0");
+
+    // `count` distinct vertices (all of them if fewer), drawn reproducibly from `seed`.
+    std::vector<int> random_sources(const Graph& graph, int count, unsigned seed);
+
+    enum class SourceStrata { Degree, Eccentricity };
+
+    // Ranks the vertices by out-degree or estimated eccentricity, cuts the ranking into
+    // `count` equal strata and draws one vertex from each, so low- and high-ranked
+    // vertices are both represented.
+    std::vector<int> stratified_sources(const Graph& graph, int count, SourceStrata by, unsigned seed);
+
+    // Hop eccentricity in the underlying undirected graph, estimated per component by a
+    // double sweep: max(dist(a, v), dist(b, v)) for the ends a, b of a long path. It is a
+    // lower bound, exact on trees.
+    std::vector<int> estimate_eccentricity(const Graph& graph);
 } // namespace graph_utils
 
 #endif //SMALLCPPPROGRAM_GRAPH_UTILS_H
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "isolation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <vector>
+
+#include "parallel.h"
+
+#if defined(__unix__)
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace isolation {
+    const char* status_name(const Status status) {
+        switch (status) {
+            case Status::Ok: return "ok";
+            case Status::Timeout: return "timeout";
+            case Status::OutOfMemory: return "oom";
+            case Status::Killed: return "killed";
+            case Status::Crashed: return "crashed";
+        }
+        return "crashed";
+    }
+
+#if defined(__unix__)
+    namespace {
+        constexpr int oom_exit = 86;   // the child hit its memory cap
+        constexpr int throw_exit = 87; // fn threw; the payload is the message
+
+        [[noreturn]] void out_of_memory() { _exit(oom_exit); }
+
+        // VmSize of /proc/self/status in bytes, 0 when unavailable.
+        long long address_space_bytes() {
+            FILE* file = std::fopen("/proc/self/status", "r");
+            if (!file) return 0;
+            char line[256];
+            long long kb = 0;
+            while (std::fgets(line, sizeof(line), file)) {
+                if (std::strncmp(line, "VmSize:", 7) == 0) {
+                    kb = std::atoll(line + 7);
+                    break;
+                }
+            }
+            std::fclose(file);
+            return kb * 1024;
+        }
+
+        void write_all(const int fd, const std::string& data) {
+            size_t done = 0;
+            while (done < data.size()) {
+                const ssize_t n = write(fd, data.data() + done, data.size() - done);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return;
+                done += static_cast<size_t>(n);
+            }
+        }
+
+        // Threads of this process, from /proc/self/task; 0 when unavailable.
+        int thread_count() {
+            DIR* dir = opendir("/proc/self/task");
+            if (!dir) return 0;
+            int count = 0;
+            while (const dirent* entry = readdir(dir)) {
+                if (entry->d_name[0] != '.') ++count;
+            }
+            closedir(dir);
+            return count;
+        }
+
+        // Pipes of jobs running on other threads are inherited as well; holding their write
+        // ends would keep those parents from seeing EOF.
+        void close_inherited_fds(const int keep) {
+            DIR* dir = opendir("/proc/self/fd");
+            if (!dir) return;
+            std::vector<int> fds;
+            while (const dirent* entry = readdir(dir)) {
+                const int fd = std::atoi(entry->d_name);
+                if (fd > 2 && fd != keep && fd != dirfd(dir)) fds.push_back(fd);
+            }
+            closedir(dir);
+            for (const int fd : fds) close(fd);
+        }
+
+        [[noreturn]] void child(const int fd, const Budget& budget, const std::function<std::string()>& fn) {
+            close_inherited_fds(fd);
+            // the pool's workers live in the parent only; a run here would wait for them forever
+            parallel::InlineScope inline_pool;
+            if (budget.memory_mb > 0) {
+                const rlim_t cap = static_cast<rlim_t>(address_space_bytes() + (budget.memory_mb << 20));
+                const rlimit limit{cap, cap};
+                setrlimit(RLIMIT_AS, &limit);
+            }
+            std::set_new_handler(out_of_memory);
+            try {
+                write_all(fd, fn());
+            } catch (const std::bad_alloc&) {
+                _exit(oom_exit);
+            } catch (const std::exception& e) {
+                write_all(fd, e.what());
+                _exit(throw_exit);
+            } catch (...) {
+                _exit(throw_exit);
+            }
+            _exit(0);
+        }
+    } // namespace
+
+    Outcome run_isolated(const Budget& budget, const std::function<std::string()>& fn) {
+        Outcome outcome;
+        // a lock another thread holds at fork time (malloc, iostreams, a pool queue) stays held in the child
+        if (const int threads = thread_count(); threads > 1) {
+            outcome.status = Status::Crashed;
+            outcome.detail = "not forked: the process runs " + std::to_string(threads) + " threads";
+            return outcome;
+        }
+        int fds[2];
+        if (pipe(fds) != 0) {
+            outcome.status = Status::Crashed;
+            outcome.detail = std::string("pipe: ") + std::strerror(errno);
+            return outcome;
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            const int err = errno;
+            close(fds[0]);
+            close(fds[1]);
+            outcome.status = Status::Crashed;
+            outcome.detail = std::string("fork: ") + std::strerror(err);
+            return outcome;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            child(fds[1], budget, fn);
+        }
+        close(fds[1]);
+
+        using clock = std::chrono::steady_clock;
+        const auto deadline = clock::now() + std::chrono::duration<double>(budget.timeout_s);
+        bool timed_out = false;
+        char buf[1 << 16];
+        while (true) {
+            int wait_ms = -1;
+            if (budget.timeout_s > 0) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+                if (left <= 0) {
+                    timed_out = true;
+                    break;
+                }
+                wait_ms = static_cast<int>(std::min<long long>(left, 1 << 30));
+            }
+            pollfd p{fds[0], POLLIN, 0};
+            const int ready = poll(&p, 1, wait_ms);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) continue; // the deadline check above ends it
+            const ssize_t n = read(fds[0], buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            outcome.payload.append(buf, static_cast<size_t>(n));
+        }
+        close(fds[0]);
+        if (timed_out) kill(pid, SIGKILL);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+        char detail[128];
+        if (timed_out) {
+            outcome.status = Status::Timeout;
+            std::snprintf(detail, sizeof(detail), "over the %g s time budget", budget.timeout_s);
+        } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            return outcome;
+        } else if (WIFEXITED(status) && WEXITSTATUS(status) == oom_exit) {
+            outcome.status = Status::OutOfMemory;
+            std::snprintf(detail, sizeof(detail), "over the %lld MB memory budget", budget.memory_mb);
+        } else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL) {
+            outcome.status = Status::Killed;
+            std::snprintf(detail, sizeof(detail), "SIGKILL from outside, most likely the OOM killer or a cgroup limit");
+        } else if (WIFSIGNALED(status)) {
+            outcome.status = Status::Crashed;
+            std::snprintf(detail, sizeof(detail), "signal %d (%s)", WTERMSIG(status), strsignal(WTERMSIG(status)));
+        } else {
+            outcome.status = Status::Crashed;
+            std::snprintf(detail, sizeof(detail), "exit code %d%s%s", WEXITSTATUS(status),
+                          outcome.payload.empty() ? "" : ": ", outcome.payload.substr(0, 64).c_str());
+        }
+        outcome.detail = detail;
+        outcome.payload.clear();
+        return outcome;
+    }
+#else
+    Outcome run_isolated(const Budget&, const std::function<std::string()>& fn) {
+        Outcome outcome;
+        outcome.payload = fn();
+        return outcome;
+    }
+#endif
+} // namespace isolation
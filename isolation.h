@@ -0,0 +1,45 @@
+#ifndef SMALLCPPPROGRAM_ISOLATION_H
+#define SMALLCPPPROGRAM_ISOLATION_H
+
+#include <functional>
+#include <string>
+
+// Measurements in a forked child, so a runaway or crashing one cannot take the sweep down.
+namespace isolation {
+
+enum class Status { Ok, Timeout, OutOfMemory, Killed, Crashed };
+
+// Lower-case name used in the results: ok, timeout, oom, killed, crashed.
+const char* status_name(Status status);
+
+// Limits of one child; 0 means none.
+struct Budget {
+    double timeout_s = 0.0;  // wall clock from fork to the child's last byte
+    long long memory_mb = 0; // address space the child may add to what it inherits
+};
+
+struct Outcome {
+    Status status = Status::Ok;
+    std::string payload; // what fn returned, when status is Ok
+    std::string detail;  // human-readable reason otherwise
+};
+
+/**
+ * @brief Runs fn in a forked child under the budget and returns its result.
+ *
+ * The memory cap is RLIMIT_AS set to the child's size at fork plus memory_mb; an
+ * allocation beyond it ends the child through the new-handler rather than unwinding
+ * through the measurement; only that counts as OutOfMemory. A SIGKILL the parent did not
+ * send is Killed: on Linux that is mostly the kernel OOM killer or a cgroup limit, when
+ * resident memory runs out before the address-space cap. Other signals are Crashed.
+ * The calling process must be single-threaded: a lock held by another thread at fork
+ * time would stay held in the child forever. When it is not, fn does not run and the
+ * outcome is Crashed. The child keeps the caller's CPU affinity and runs
+ * parallel::default_pool() work inline. Without fork (non-POSIX builds) fn runs
+ * in-process and the budget is ignored.
+ */
+Outcome run_isolated(const Budget& budget, const std::function<std::string()>& fn);
+
+} // namespace isolation
+
+#endif //SMALLCPPPROGRAM_ISOLATION_H
@@ -4,15 +4,36 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <cctype>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
 
 #include "graph_types.h"
 #include "dijkstra.h"
 #include "bellman_ford.h"
 #include "bmssp.h"
+#include "scc.h"
 #include "graph_generators.h"
 #include "benchmark.h"
 #include "graph_utils.h"
 #include "config.h"
+#include "autotune.h"
+#include "perf_counters.h"
+#include "memory_stats.h"
+#include "runner.h"
+#include "validation.h"
+#include "results.h"
+#include "isolation.h"
+#include "parallel.h"
 
 static std::string escape_csv(const std::string& s) {
     if (s.find(',') != std::string::npos || s.find('"') != std::string::npos || s.find('\n') != std::string::npos) {
@@ -27,10 +48,510 @@ static std::string escape_csv(const std::string& s) {
     return s;
 }
 
+static const char* const profile_header =
+    "Experiment\tGenerator\tGraph\tVertices\tEdges\tLevel\tCalls\tLeafCalls"
+    "\tPivotS\tPivotP\tPivotW\tInserts\tPulls\tPulled\tSplits\tPrepends\tPrepended"
+    "\tHeapPushes\tHeapPops\tPivot_ms\tPull_ms\tRelax_ms\tPrepend_ms\tLeaf_ms\n";
+
+// One row per recursion level, averaged per query; rows of config.profile_output.
+static void write_bmssp_profile(std::ostream& out, const std::string& row_prefix,
+                                const std::vector<BmsspLevelProfile>& levels, long long queries) {
+    const double q = static_cast<double>(std::max(queries, 1LL));
+    out << std::fixed << std::setprecision(4);
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) { // top level first
+        const auto& p = *it;
+        out << row_prefix << "\t" << p.level
+            << "\t" << p.calls / q << "\t" << p.leaf_calls / q
+            << "\t" << p.pivot_sources / q << "\t" << p.pivots / q << "\t" << p.pivot_visited / q
+            << "\t" << p.inserts / q << "\t" << p.pulls / q << "\t" << p.pulled / q
+            << "\t" << p.splits / q << "\t" << p.prepends / q << "\t" << p.prepended / q
+            << "\t" << p.heap_pushes / q << "\t" << p.heap_pops / q
+            << "\t" << p.pivot_ms / q << "\t" << p.pull_ms / q << "\t" << p.relax_ms / q
+            << "\t" << p.prepend_ms / q << "\t" << p.leaf_ms / q << "\n";
+    }
+}
+
+static const char* const samples_header =
+    "Experiment\tGenerator\tGraph\tVertices\tEdges\tAlgorithm\tIteration\tSource\tTime_ms\tOutlier\n";
+
+// One row per measured iteration; rows of config.samples_output.
+static void write_samples(std::ostream& out, const std::string& row_prefix, const BenchmarkResult& result) {
+    const std::vector<double>& samples_ms = result.samples_ms;
+    const std::vector<bool> outlier = sample_stats::mad_outliers_per_group(samples_ms, static_cast<size_t>(std::max(1, result.sources)));
+    out << std::fixed << std::setprecision(6);
+    for (size_t i = 0; i < samples_ms.size(); ++i) {
+        out << row_prefix << "\t" << i << "\t" << result.sample_sources[i] << "\t" << samples_ms[i]
+            << "\t" << (outlier[i] ? 1 : 0) << "\n";
+    }
+}
+
+static const char* const memory_column_names[] = {
+    "PrepAllocs", "PrepAllocBytes", "PrepPeakLive_bytes", "PrepPeakRSS_kB",
+    "QueryAllocs", "QueryAllocBytes", "QueryPeakLive_bytes", "QueryPeakRSS_kB"};
+
+static std::string fixed_cell(const double x, const int precision) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(precision) << x;
+    return out.str();
+}
+
+/**
+ * Every column of a result row up to the Valid column, as (header, cell); the header is
+ * taken from a default Row, so it and every row, failed ones included, come from this one
+ * list. A failed row shows its status in place of AvgTime_ms, 0 iterations, and its CPU.
+ * Counter cells the run did not measure stay empty, and so do the preprocessing memory
+ * cells of algorithms without a preprocessing step.
+ */
+static std::vector<std::pair<std::string, std::string>> tsv_cells(const results::Row& row, const bool counter_columns,
+                                                                  const bool memory_columns) {
+    const BenchmarkResult& result = row.result;
+    const bool ok = result.success;
+    std::vector<std::pair<std::string, std::string>> cells;
+    const auto add = [&](std::string name, std::string value) { cells.emplace_back(std::move(name), std::move(value)); };
+    const auto measured = [&](std::string name, std::string value) { add(std::move(name), ok ? std::move(value) : ""); };
+
+    add("Experiment", escape_csv(row.experiment));
+    add("Generator", row.generator);
+    add("Graph", escape_csv(row.graph));
+    add("Vertices", std::to_string(result.vertices));
+    add("Edges", std::to_string(row.edges));
+    add("Algorithm", row.algorithm);
+    std::string word = row.status;
+    for (char& c : word) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    add("AvgTime_ms", ok ? fixed_cell(result.avg_time_ms, 4) : word);
+    measured("MinTime_ms", fixed_cell(result.min_time_ms, 4));
+    measured("MaxTime_ms", fixed_cell(result.max_time_ms, 4));
+    measured("StdDev_ms", fixed_cell(result.std_dev_ms, 4));
+    add("Iterations", ok ? std::to_string(result.iterations) : "0");
+    measured("Median_ms", fixed_cell(result.median_ms, 4));
+    measured("P90_ms", fixed_cell(result.p90_ms, 4));
+    measured("P99_ms", fixed_cell(result.p99_ms, 4));
+    measured("CI95Low_ms", fixed_cell(result.ci_low_ms, 4));
+    measured("CI95High_ms", fixed_cell(result.ci_high_ms, 4));
+    measured("Outliers", std::to_string(result.outliers));
+    for (int p = 0; p < kPhaseCount; ++p) {
+        std::string name = phase_name(static_cast<Phase>(p));
+        name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+        measured(name + "_ms", fixed_cell(result.phase_ms[p], 4));
+    }
+    measured("Sources", std::to_string(result.sources));
+    measured("QPS", fixed_cell(result.qps, 1));
+    add("CPU", std::to_string(row.cpu));
+    add("Governor", row.governor);
+
+    if (counter_columns) { // Cycles .. dTLB_misses plus IPC, per iteration
+        const auto find = [&](const std::string& name) -> const double* {
+            for (const auto& [key, value] : result.counters) {
+                if (key == name) return &value;
+            }
+            return nullptr;
+        };
+        const double* cycles = find(perf::event_name(perf::Cycles));
+        const double* instructions = find(perf::event_name(perf::Instructions));
+        for (int e = 0; e < perf::EventCount; ++e) {
+            if (e == perf::L1dMisses) { // IPC goes right after the two it is made of
+                measured("IPC", cycles && instructions && *cycles > 0 ? fixed_cell(*instructions / *cycles, 3) : "");
+            }
+            const double* value = find(perf::event_name(e));
+            measured(perf::event_name(e), value ? fixed_cell(*value, 0) : "");
+        }
+    }
+    if (memory_columns) { // preprocessing then per-query memory
+        for (const bool prep : {true, false}) {
+            const memory_stats::Usage& u = prep ? result.preprocessing_memory : result.query_memory;
+            const bool has = ok && result.memory_measured && (!prep || result.has_preprocessing);
+            const long long values[] = {u.allocations, u.bytes, u.peak_live_bytes, u.peak_rss_kb};
+            for (int i = 0; i < 4; ++i) add(memory_column_names[(prep ? 0 : 4) + i], has ? std::to_string(values[i]) : "");
+        }
+    }
+    return cells;
+}
+
+// Text one (graph, algorithm) job produces; printed in job order whatever order the jobs finish in.
+struct JobOutput {
+    std::string row; // up to the Valid column, which needs the other algorithms' results
+    std::string metrics;
+    std::string profile_rows;
+    std::string sample_rows;
+    bool validated = false;
+    std::vector<std::pair<int, validation::Checksum>> checksums; // per source
+    long long violations = 0; // verify_distances findings over all sources
+    results::Row record;      // the row for --json/--csv and --compare
+};
+
+// Copies of an experiment's graphs, made on first use by a worker of each NUMA node so that
+// first touch places their pages on that node.
+class NodeLocalGraphs {
+public:
+    explicit NodeLocalGraphs(const std::vector<Graph>& graphs) : graphs_(graphs) {}
+
+    const Graph& get(const size_t g, const int node) {
+        if (node < 0) return graphs_[g];
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& copy = copies_[{g, node}];
+        if (!copy) copy = std::make_unique<Graph>(graphs_[g]);
+        return *copy;
+    }
+
+private:
+    const std::vector<Graph>& graphs_;
+    std::mutex mutex_;
+    std::map<std::pair<size_t, int>, std::unique_ptr<Graph>> copies_;
+};
+
+// A JobOutput through the isolation pipe: length-prefixed fields, the record as JSON.
+static void put_bytes(std::string& out, const void* data, const size_t size) {
+    const uint64_t n = size;
+    out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.append(static_cast<const char*>(data), size);
+}
+
+static std::string take_bytes(const std::string& in, size_t& pos) {
+    uint64_t n = 0;
+    if (pos + sizeof(n) > in.size()) throw std::runtime_error("truncated job output");
+    std::memcpy(&n, in.data() + pos, sizeof(n));
+    pos += sizeof(n);
+    if (pos + n > in.size()) throw std::runtime_error("truncated job output");
+    std::string field = in.substr(pos, n);
+    pos += n;
+    return field;
+}
+
+static std::string encode_output(const JobOutput& output) {
+    std::string out;
+    for (const std::string* field : {&output.row, &output.metrics, &output.profile_rows, &output.sample_rows}) {
+        put_bytes(out, field->data(), field->size());
+    }
+    const std::string record = results::to_json(output.record);
+    put_bytes(out, record.data(), record.size());
+    const char validated = output.validated ? 1 : 0;
+    put_bytes(out, &validated, 1);
+    put_bytes(out, &output.violations, sizeof(output.violations));
+    std::string sums;
+    for (const auto& [source, sum] : output.checksums) {
+        sums.append(reinterpret_cast<const char*>(&source), sizeof(source));
+        sums.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    }
+    put_bytes(out, sums.data(), sums.size());
+    return out;
+}
+
+static JobOutput decode_output(const std::string& in) {
+    JobOutput output;
+    size_t pos = 0;
+    for (std::string* field : {&output.row, &output.metrics, &output.profile_rows, &output.sample_rows}) {
+        *field = take_bytes(in, pos);
+    }
+    output.record = results::row_from_json(take_bytes(in, pos));
+    output.validated = take_bytes(in, pos) == std::string(1, 1);
+    std::memcpy(&output.violations, take_bytes(in, pos).data(), sizeof(output.violations));
+    const std::string sums = take_bytes(in, pos);
+    constexpr size_t entry = sizeof(int) + sizeof(validation::Checksum);
+    for (size_t at = 0; at + entry <= sums.size(); at += entry) {
+        int source;
+        validation::Checksum sum;
+        std::memcpy(&source, sums.data() + at, sizeof(source));
+        std::memcpy(&sum, sums.data() + at + sizeof(source), sizeof(sum));
+        output.checksums.emplace_back(source, sum);
+    }
+    return output;
+}
+
+// Checksums of the first algorithm validated on a graph; the ones after it are compared against them.
+struct ValidationReference {
+    std::string algorithm;
+    std::vector<std::pair<int, validation::Checksum>> checksums;
+};
+
+// Cell of the Valid column: "ref" for the reference itself, then "ok" or "mismatch:k/n" (sources
+// disagreeing out of those both ran), plus ";triangle:v" when verify_distances found violations.
+static std::string validation_cell(const JobOutput& output, const std::string& algorithm, const std::string& where,
+                                   const double tolerance, ValidationReference& reference) {
+    if (!output.validated) return "";
+    std::string cell;
+    if (reference.algorithm.empty()) {
+        reference = {algorithm, output.checksums};
+        cell = "ref";
+    } else {
+        int compared = 0, mismatched = 0;
+        for (const auto& [source, sum] : output.checksums) {
+            for (const auto& [ref_source, ref_sum] : reference.checksums) {
+                if (ref_source != source) continue;
+                ++compared;
+                if (!validation::agree(sum, ref_sum, tolerance)) ++mismatched;
+            }
+        }
+        if (compared == 0) {
+            cell = "unchecked";
+        } else if (mismatched > 0) {
+            cell = "mismatch:" + std::to_string(mismatched) + "/" + std::to_string(compared);
+            std::cerr << "Warning: " << algorithm << " disagrees with " << reference.algorithm << " on "
+                      << where << " from " << mismatched << " of " << compared << " sources\n";
+        } else {
+            cell = "ok";
+        }
+    }
+    if (output.violations > 0) {
+        cell += ";triangle:" + std::to_string(output.violations);
+        std::cerr << "Warning: " << algorithm << " distances on " << where << " fail "
+                  << output.violations << " edge checks\n";
+    }
+    return cell;
+}
+
+static long long edge_count_of(const Graph& graph) {
+    long long edge_count = 0;
+    for (int i = 0; i < graph.size(); ++i) {
+        edge_count += static_cast<long long>(graph.adj[i].size());
+    }
+    return edge_count;
+}
+
+static std::string graph_label_of(const ExperimentConfig& exp, const Graph& graph) {
+    return graph.name.empty() ? exp.generator_type : graph.name;
+}
+
+// Fills the TSV row, metrics and record of a finished job; `status` is "ok", "error" or how an
+// isolated run ended, and takes the place of ERROR in a failed row.
+static void finish_output(JobOutput& output, const ExperimentConfig& exp, const Graph& graph,
+                          const std::string& algorithm, BenchmarkResult result, const int cpu,
+                          const std::string& status, const bool counter_columns, const bool memory_columns) {
+    const long long edge_count = edge_count_of(graph);
+    const std::string graph_label = graph_label_of(exp, graph);
+    if (result.success) {
+        std::ostringstream metrics;
+        metrics << std::fixed << std::setprecision(4);
+        for (size_t i = 0; i < result.metrics.size(); ++i) {
+            metrics << (i ? ";" : "") << result.metrics[i].first << "=" << result.metrics[i].second;
+        }
+        output.metrics = metrics.str();
+    }
+
+    output.record.experiment = exp.name;
+    output.record.generator = exp.generator_type;
+    output.record.graph = graph_label;
+    output.record.algorithm = algorithm;
+    output.record.edges = edge_count;
+    output.record.cpu = cpu;
+    output.record.governor = runner::governor(cpu);
+    output.record.status = status;
+    result.vertices = graph.size();
+    output.record.result = std::move(result);
+
+    std::string row;
+    for (const auto& [name, cell] : tsv_cells(output.record, counter_columns, memory_columns)) row += cell + "\t";
+    output.row = std::move(row);
+}
+
+static JobOutput run_job(const ExperimentConfig& exp, const Graph& graph, const AlgorithmConfig& algo,
+                         const std::vector<int>& shared_sources, const runner::Slot& slot,
+                         const bool counter_columns, const bool memory_columns) {
+    JobOutput output;
+    const long long edge_count = edge_count_of(graph);
+    const std::string graph_label = graph_label_of(exp, graph);
+
+    // the group counts the calling thread only, so every job opens its own
+    std::optional<perf::CounterGroup> counter_group;
+    if (exp.benchmark.counters) counter_group.emplace();
+
+    BenchmarkOptions options;
+    options.counters = counter_group ? &*counter_group : nullptr;
+    options.memory = exp.benchmark.memory;
+    options.reject_outliers = exp.benchmark.reject_outliers;
+    options.adaptive = {exp.benchmark.target_ci, exp.benchmark.time_budget_ms, exp.benchmark.max_iterations};
+    options.headline = exp.benchmark.headline;
+
+    const std::vector<int> sources = shared_sources.empty() ? std::vector<int>{algo.start_node} : shared_sources;
+    BenchmarkResult result;
+    result.vertices = graph.size();
+    result.iterations = 0;
+    result.success = true;
+    std::function<std::vector<double>(int)> solve; // untimed query for validation
+
+    try {
+        if (algo.name == "dijkstra") {
+            result = run_benchmark_sources(
+                graph,
+                [&graph, &algo](int s) { return dijkstra(graph, s, algo.log ? "dijkstra.log" : ""); },
+                exp.benchmark.iterations,
+                exp.benchmark.warmup,
+                options,
+                sources
+            );
+            result.algorithm_name = "dijkstra";
+            solve = [&graph](int s) { return dijkstra(graph, s, ""); };
+        } else if (algo.name == "bellman_ford") {
+            result = run_benchmark_sources(
+                graph,
+                [&graph](int s) { return bellman_ford(graph, s); },
+                exp.benchmark.iterations,
+                exp.benchmark.warmup,
+                options,
+                sources
+            );
+            result.algorithm_name = "bellman_ford";
+            solve = [&graph](int s) { return bellman_ford(graph, s); };
+        } else if (algo.name == "scc_dijkstra" || algo.name == "scc_bellman_ford") {
+            const auto inner = algo.name == "scc_dijkstra"
+                ? SccInnerSolver::Dijkstra
+                : SccInnerSolver::BellmanFord;
+            result = run_benchmark_sources(
+                graph,
+                [&graph, inner](int s) { return scc_sssp(graph, s, inner); },
+                exp.benchmark.iterations,
+                exp.benchmark.warmup,
+                options,
+                sources
+            );
+            result.algorithm_name = algo.name;
+            solve = [&graph, inner](int s) { return scc_sssp(graph, s, inner); };
+        } else if (algo.name == "bmssp") {
+            BenchmarkOptions bmssp_options = options;
+            std::optional<memory_stats::Scope> prep_memory;
+            if (options.memory) prep_memory.emplace();
+            const auto prep_start = std::chrono::steady_clock::now();
+            auto solver = std::make_unique<bmssp<double>>(graph);
+            solver->set_params(algo.bmssp);
+            solver->prepare_graph(true);
+            bmssp_options.prepare_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - prep_start).count();
+            const memory_stats::Usage prep_usage = prep_memory ? prep_memory->finish() : memory_stats::Usage{};
+            if (algo.log) solver->context().set_log_file("bmssp.log");
+
+            result = run_benchmark_sources(
+                graph,
+                [&solver](QueryPhases& phases, int s) {
+                    const BmsspStats before = solver->get_stats();
+                    auto dist = solver->query(s).dist;
+                    const BmsspStats& after = solver->get_stats();
+                    phases.attribute(Phase::Setup, after.setup_ms - before.setup_ms);
+                    phases.attribute(Phase::Extract, after.extract_ms - before.extract_ms);
+                    return dist;
+                },
+                exp.benchmark.iterations,
+                exp.benchmark.warmup,
+                bmssp_options,
+                sources
+            );
+            result.algorithm_name = "bmssp";
+            result.has_preprocessing = true;
+            result.preprocessing_memory = prep_usage;
+
+            const auto& stats = solver->get_stats();
+            if (stats.queries > 0) {
+                const double q = static_cast<double>(stats.queries);
+                const double leaves = stats.base_case_ms + stats.hybrid_ms;
+                result.metrics = {
+                    {"recursion_ms", (stats.total_ms - leaves) / q},
+                    {"base_case_ms", stats.base_case_ms / q},
+                    {"hybrid_ms", stats.hybrid_ms / q},
+                    {"hybrid_calls", stats.hybrid_calls / q},
+                    {"hybrid_cutoff", static_cast<double>(solver->effective_params().hybrid_cutoff)},
+                };
+            }
+            if (algo.bmssp.profile) {
+                std::ostringstream prefix, rows;
+                prefix << escape_csv(exp.name) << "\t" << exp.generator_type << "\t"
+                       << escape_csv(graph_label) << "\t" << graph.size() << "\t" << edge_count;
+                write_bmssp_profile(rows, prefix.str(), solver->get_profile(), stats.queries);
+                output.profile_rows = rows.str();
+            }
+            if (algo.log) solver->context().set_log_file(""); // validation re-runs must not overwrite the trace
+            solve = [solver = std::shared_ptr<bmssp<double>>(std::move(solver))](int s) {
+                const auto dist = solver->query(s).dist;
+                return std::vector<double>(dist.begin(), dist.end());
+            };
+        } else {
+            result.success = false;
+            result.error_msg = "Unknown algorithm: " + algo.name;
+        }
+
+        if (exp.benchmark.validate && result.success && solve) {
+            for (const int s : sources) {
+                const std::vector<double> dist = solve(s);
+                output.checksums.emplace_back(s, validation::checksum(dist));
+                if (exp.benchmark.validate_triangle) {
+                    output.violations += validation::verify_distances(graph, s, dist, exp.benchmark.validate_tolerance).total();
+                }
+            }
+            output.validated = true;
+        }
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_msg = e.what();
+    }
+
+    if (exp.benchmark.record_samples && result.success) {
+        std::ostringstream prefix, rows;
+        prefix << escape_csv(exp.name) << "\t" << exp.generator_type << "\t"
+               << escape_csv(graph_label) << "\t" << graph.size() << "\t" << edge_count << "\t" << algo.name;
+        write_samples(rows, prefix.str(), result);
+        output.sample_rows = rows.str();
+    }
+
+    const int cpu = slot.cpu >= 0 ? slot.cpu : runner::current_cpu();
+    const std::string status = result.success ? "ok" : "error";
+    finish_output(output, exp, graph, algo.name, std::move(result), cpu, status, counter_columns, memory_columns);
+    return output;
+}
+
 int main(int argc, char* argv[]) {
+    // usage: SmallCppProgram [config.yaml] [--autotune[=output.yaml]] [--jobs=N] [--json=out.json] [--csv=out.csv]
+    //                        [--compare=baseline.json [--threshold=0.05] [--alpha=0.01]] [--fit[=complexity.tsv]]
+    // with --compare or --fit, a .json file in place of the config compares or fits that saved run instead of a new one
     std::string config_file = "config.yaml";
-    if (argc > 1) {
-        config_file = argv[1];
+    std::string autotune_file;
+    std::optional<int> jobs_override;
+    std::optional<std::string> json_override, csv_override, fit_override;
+    std::string baseline_file;
+    results::CompareOptions compare_options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--autotune") {
+            autotune_file = "bmssp_tuned.yaml";
+        } else if (arg.rfind("--autotune=", 0) == 0) {
+            autotune_file = arg.substr(std::string("--autotune=").size());
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            jobs_override = std::max(0, std::atoi(arg.c_str() + std::string("--jobs=").size()));
+        } else if (arg.rfind("--json=", 0) == 0) {
+            json_override = arg.substr(std::string("--json=").size());
+        } else if (arg.rfind("--csv=", 0) == 0) {
+            csv_override = arg.substr(std::string("--csv=").size());
+        } else if (arg == "--fit") {
+            fit_override = "complexity.tsv";
+        } else if (arg.rfind("--fit=", 0) == 0) {
+            fit_override = arg.substr(std::string("--fit=").size());
+        } else if (arg.rfind("--compare=", 0) == 0) {
+            baseline_file = arg.substr(std::string("--compare=").size());
+        } else if (arg.rfind("--threshold=", 0) == 0) {
+            compare_options.threshold = std::atof(arg.c_str() + std::string("--threshold=").size());
+        } else if (arg.rfind("--alpha=", 0) == 0) {
+            compare_options.alpha = std::atof(arg.c_str() + std::string("--alpha=").size());
+        } else {
+            config_file = arg;
+        }
+    }
+
+    const auto ends_with = [](const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if ((!baseline_file.empty() || fit_override) && ends_with(config_file, ".json")) {
+        try {
+            results::Environment current_env;
+            const auto current = results::load_json(config_file, &current_env);
+            if (fit_override) {
+                std::ofstream out(*fit_override);
+                results::write_complexity(out, current);
+            }
+            if (baseline_file.empty()) return 0;
+            results::Environment baseline_env;
+            const auto baseline = results::load_json(baseline_file, &baseline_env);
+            results::report_environment_changes(baseline_env, current_env, std::cout);
+            return results::compare(baseline, current, compare_options, std::cout) > 0 ? 2 : 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to process " << config_file << ": " << e.what() << "\n";
+            return 1;
+        }
     }
 
     Config config;
@@ -40,8 +561,84 @@ int main(int argc, char* argv[]) {
         std::cerr << "Failed to parse config: " << e.what() << "\n";
         return 1;
     }
+    if (jobs_override) config.runner.jobs = *jobs_override;
+    if (json_override) config.json_output = *json_override;
+    if (csv_override) config.csv_output = *csv_override;
+    if (fit_override) config.complexity_output = *fit_override;
+
+    // loaded before the run, so a bad baseline fails fast
+    std::vector<results::Row> baseline;
+    results::Environment baseline_env;
+    if (!baseline_file.empty()) {
+        try {
+            baseline = results::load_json(baseline_file, &baseline_env);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load baseline: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    const bool keep_rows = !config.json_output.empty() || !config.csv_output.empty() ||
+                           !config.complexity_output.empty() || !baseline_file.empty();
+    std::vector<results::Row> all_rows;
+
+    if (!autotune_file.empty()) {
+        try {
+            const auto tuned = autotune::tune_bmssp(config, std::cout);
+            return autotune::save_tuned_params(tuned, autotune_file) ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Autotuning failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
 
-    std::cout << "Experiment\tGenerator\tGraph\tVertices\tEdges\tAlgorithm\tAvgTime_ms\tMinTime_ms\tMaxTime_ms\tStdDev_ms\tIterations\n";
+    std::ofstream profile_file; // opened by the first bmssp entry with profile: true
+    std::ofstream samples_file; // opened by the first experiment with record_samples: true
+
+    const bool counter_columns = std::any_of(config.experiments.begin(), config.experiments.end(),
+                                             [](const ExperimentConfig& e) { return e.benchmark.counters; });
+    if (counter_columns) {
+        const perf::CounterGroup probe;
+        if (!probe.available()) {
+            std::cerr << "Warning: hardware counters unavailable, " << probe.error() << "\n";
+        }
+    }
+
+    // An isolated job is forked, and a fork copies only the calling thread: locks other threads hold
+    // would stay held in the child. Isolation therefore runs the whole sweep on the main thread, with
+    // no concurrent jobs, no pinned workers and no default_pool() threads.
+    const bool isolating = std::any_of(config.experiments.begin(), config.experiments.end(), [](const ExperimentConfig& e) {
+        return e.benchmark.isolate || e.benchmark.timeout_s > 0 || e.benchmark.memory_mb > 0 ||
+               std::any_of(e.algorithms.begin(), e.algorithms.end(),
+                           [](const AlgorithmConfig& a) { return a.timeout_s > 0 || a.memory_mb > 0; });
+    });
+    std::optional<parallel::InlineScope> single_threaded;
+    if (isolating) {
+        const runner::Options& r = config.runner;
+        if (r.jobs != 1 || r.pin || r.physical_cores || r.numa_local) {
+            std::cerr << "Note: isolated jobs are forked, so the sweep runs one job at a time on the main thread\n";
+        }
+        config.runner = {};
+        single_threaded.emplace();
+    }
+
+    const runner::Scheduler scheduler(config.runner);
+    if (scheduler.width() > 1 || scheduler.pinned()) {
+        std::cerr << "Running " << scheduler.width() << " jobs at a time";
+        if (scheduler.pinned()) {
+            std::cerr << " on CPUs";
+            for (const auto& cpu : scheduler.cpus()) std::cerr << " " << cpu.id;
+        }
+        std::cerr << "\n";
+    }
+    const bool node_copies = config.runner.numa_local && scheduler.pinned() && scheduler.numa_nodes() > 1;
+
+    const bool memory_columns = std::any_of(config.experiments.begin(), config.experiments.end(),
+                                            [](const ExperimentConfig& e) { return e.benchmark.memory; });
+    for (const auto& [name, cell] : tsv_cells(results::Row{}, counter_columns, memory_columns)) std::cout << name << "\t";
+    const bool validate_column = std::any_of(config.experiments.begin(), config.experiments.end(),
+                                             [](const ExperimentConfig& e) { return e.benchmark.validate; });
+    if (validate_column) std::cout << "Valid\t";
+    std::cout << "Metrics\n";
 
     for (size_t exp_idx = 0; exp_idx < config.experiments.size(); ++exp_idx) {
         const auto& exp = config.experiments[exp_idx];
@@ -54,88 +651,148 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
+        struct Job {
+            size_t graph;
+            const AlgorithmConfig* algo;
+        };
+        std::vector<Job> jobs;
+        std::vector<std::vector<int>> graph_sources(graphs.size());
         for (size_t g_idx = 0; g_idx < graphs.size(); ++g_idx) {
-            const auto& graph = graphs[g_idx];
-            long long edge_count = 0;
-            for (int i = 0; i < graph.size(); ++i) {
-                edge_count += static_cast<long long>(graph.adj[i].size());
+            try {
+                graph_sources[g_idx] = select_sources(exp, graphs[g_idx]);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                continue;
             }
+            for (const auto& algo : exp.algorithms) jobs.push_back({g_idx, &algo});
+        }
+
+        NodeLocalGraphs local_graphs(graphs);
+        // per algorithm entry, the smallest graph it ran out of budget on (skip_larger)
+        std::vector<std::optional<std::pair<int, long long>>> exceeded(exp.algorithms.size());
+        std::mutex exceeded_mutex;
+        std::vector<ValidationReference> references(graphs.size());
+        std::vector<std::optional<JobOutput>> outputs(jobs.size());
+        size_t printed = 0;
+        std::mutex output_mutex;
+
+        scheduler.run(
+            jobs.size(),
+            // memory accounting is process-wide and trace files are shared, so those jobs run alone
+            [&](const size_t i) { return exp.benchmark.memory || jobs[i].algo->log; },
+            [&](const size_t i, const runner::Slot& slot) {
+                const Job& job = jobs[i];
+                const AlgorithmConfig& algo = *job.algo;
+                const size_t algo_idx = static_cast<size_t>(job.algo - exp.algorithms.data());
+                const Graph& graph = node_copies ? local_graphs.get(job.graph, slot.node) : graphs[job.graph];
+                const int cpu = slot.cpu >= 0 ? slot.cpu : runner::current_cpu();
+                const auto failed = [&](const std::string& status, const std::string& reason) {
+                    JobOutput output;
+                    BenchmarkResult result{};
+                    result.success = false;
+                    result.error_msg = reason;
+                    finish_output(output, exp, graph, algo.name, std::move(result), cpu, status,
+                                  counter_columns, memory_columns);
+                    return output;
+                };
 
-            std::string graph_label = graph.name.empty() ? exp.generator_type : graph.name;
-
-            for (const auto& algo : exp.algorithms) {
-                BenchmarkResult result;
-                result.vertices = graph.size();
-                result.iterations = 0;
-                result.success = true;
-
-                try {
-                    if (algo.name == "dijkstra") {
-                        result = run_benchmark(
-                            graph,
-                            [&graph](int s) { return dijkstra(graph, s); },
-                            exp.benchmark.iterations,
-                            exp.benchmark.warmup,
-                            algo.start_node
-                        );
-                        result.algorithm_name = "dijkstra";
-                    } else if (algo.name == "bellman_ford") {
-                        result = run_benchmark(
-                            graph,
-                            [&graph](int s) { return bellman_ford(graph, s); },
-                            exp.benchmark.iterations,
-                            exp.benchmark.warmup,
-                            algo.start_node
-                        );
-                        result.algorithm_name = "bellman_ford";
-                    } else if (algo.name == "bmssp") {
-                        auto edges = graph.edges();
-                        auto solver = std::make_unique<bmssp<double>>(graph.size());
-                        for (const auto& [u, v, w] : edges) {
-                            solver->addEdge(u, v, w);
+                isolation::Budget budget;
+                budget.timeout_s = algo.timeout_s >= 0 ? algo.timeout_s : exp.benchmark.timeout_s;
+                budget.memory_mb = algo.memory_mb >= 0 ? algo.memory_mb : exp.benchmark.memory_mb;
+                const bool isolate = exp.benchmark.isolate || budget.timeout_s > 0 || budget.memory_mb > 0;
+
+                std::optional<std::pair<int, long long>> limit;
+                {
+                    std::lock_guard<std::mutex> lock(exceeded_mutex);
+                    limit = exceeded[algo_idx];
+                }
+                JobOutput output;
+                if (limit && graph.size() >= limit->first && edge_count_of(graph) >= limit->second) {
+                    output = failed("skipped", "over budget at " + std::to_string(limit->first) + " vertices");
+                } else if (isolate) {
+                    const isolation::Outcome outcome = isolation::run_isolated(budget, [&] {
+                        return encode_output(run_job(exp, graph, algo, graph_sources[job.graph], slot,
+                                                     counter_columns, memory_columns));
+                    });
+                    if (outcome.status == isolation::Status::Ok) {
+                        try {
+                            output = decode_output(outcome.payload);
+                        } catch (const std::exception& e) {
+                            output = failed("crashed", e.what());
                         }
-                        solver->prepare_graph(true);
-
-                        result = run_benchmark(
-                            graph,
-                            [solver = std::move(solver)](int s) mutable {
-                                auto [dist, _] = solver->execute(s);
-                                return dist;
-                            },
-                            exp.benchmark.iterations,
-                            exp.benchmark.warmup,
-                            algo.start_node
-                        );
-                        result.algorithm_name = "bmssp";
                     } else {
-                        result.success = false;
-                        result.error_msg = "Unknown algorithm: " + algo.name;
+                        const std::string status = isolation::status_name(outcome.status);
+                        output = failed(status, outcome.detail);
+                        // a crash says nothing about size; the budgets and the OOM killer (killed) do
+                        if (exp.benchmark.skip_larger && outcome.status != isolation::Status::Crashed) {
+                            std::lock_guard<std::mutex> lock(exceeded_mutex);
+                            auto& first = exceeded[algo_idx];
+                            if (!first || graph.size() < first->first) first.emplace(graph.size(), edge_count_of(graph));
+                        }
                     }
-                } catch (const std::exception& e) {
-                    result.success = false;
-                    result.error_msg = e.what();
+                } else {
+                    output = run_job(exp, graph, algo, graph_sources[job.graph], slot, counter_columns, memory_columns);
                 }
 
-                std::cout << escape_csv(exp.name) << "\t"
-                          << exp.generator_type << "\t"
-                          << escape_csv(graph_label) << "\t"
-                          << graph.size() << "\t"
-                          << edge_count << "\t"
-                          << algo.name << "\t";
-
-                if (result.success) {
-                    std::cout << std::fixed << std::setprecision(4)
-                              << result.avg_time_ms << "\t"
-                              << result.min_time_ms << "\t"
-                              << result.max_time_ms << "\t"
-                              << result.std_dev_ms << "\t"
-                              << result.iterations;
-                } else {
-                    std::cout << "ERROR\t\t\t\t0";
+                std::lock_guard<std::mutex> lock(output_mutex);
+                outputs[i] = std::move(output);
+                for (; printed < outputs.size() && outputs[printed]; ++printed) {
+                    const JobOutput& ready = *outputs[printed];
+                    if (!ready.profile_rows.empty()) {
+                        if (!profile_file.is_open()) {
+                            profile_file.open(config.profile_output);
+                            profile_file << profile_header;
+                        }
+                        profile_file << ready.profile_rows;
+                    }
+                    if (!ready.sample_rows.empty()) {
+                        if (!samples_file.is_open()) {
+                            samples_file.open(config.samples_output);
+                            samples_file << samples_header;
+                        }
+                        samples_file << ready.sample_rows;
+                    }
+                    std::cout << ready.row;
+                    if (ready.record.status != "ok" && ready.record.status != "error") {
+                        std::cerr << "Warning: " << ready.record.algorithm << " on " << ready.record.graph << ": "
+                                  << ready.record.status << ", " << ready.record.result.error_msg << "\n";
+                    }
+                    std::string valid;
+                    if (validate_column) {
+                        const Job& done = jobs[printed];
+                        const Graph& g = graphs[done.graph];
+                        const std::string where = exp.name + " / " + (g.name.empty() ? exp.generator_type : g.name);
+                        valid = validation_cell(ready, done.algo->name, where, exp.benchmark.validate_tolerance,
+                                                references[done.graph]);
+                        std::cout << valid << "\t";
+                    }
+                    std::cout << ready.metrics << "\n";
+                    if (keep_rows) {
+                        all_rows.push_back(std::move(outputs[printed]->record));
+                        all_rows.back().valid = valid;
+                    }
+                    outputs[printed].reset();
                 }
-                std::cout << "\n";
-            }
-        }
+            });
+    }
+
+    const results::Environment env = keep_rows ? results::collect_environment(config_file) : results::Environment{};
+    if (!config.json_output.empty()) {
+        std::ofstream out(config.json_output);
+        results::write_json(out, env, all_rows);
+    }
+    if (!config.csv_output.empty()) {
+        std::ofstream out(config.csv_output);
+        results::write_csv(out, env, all_rows);
+    }
+    if (!config.complexity_output.empty()) {
+        std::ofstream out(config.complexity_output);
+        results::write_complexity(out, all_rows);
+    }
+    if (!baseline_file.empty()) {
+        // stdout carries the results table, so the comparison goes to stderr
+        results::report_environment_changes(baseline_env, env, std::cerr);
+        if (results::compare(baseline, all_rows, compare_options, std::cerr) > 0) return 2;
     }
 
     return 0;
@@ -0,0 +1,136 @@
+#include "memory_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace memory_stats {
+    namespace {
+        std::atomic<bool> counting{false};
+        std::atomic<long long> allocations{0}, allocated_bytes{0}, live_bytes{0}, peak_live_bytes{0};
+
+        // Sizes come from the allocator so that frees are charged what the allocation was.
+        long long block_size(void* p) {
+#if defined(__GLIBC__)
+            return static_cast<long long>(malloc_usable_size(p));
+#else
+            (void)p;
+            return 0;
+#endif
+        }
+
+        // "VmRSS:    1234 kB" style fields of /proc/self/status; stdio keeps it off operator new.
+        long long status_kb(const char* key) {
+            FILE* file = std::fopen("/proc/self/status", "r");
+            if (!file) return 0;
+            char line[256];
+            long long kb = 0;
+            const size_t key_len = std::strlen(key);
+            while (std::fgets(line, sizeof(line), file)) {
+                if (std::strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+                    kb = std::atoll(line + key_len + 1);
+                    break;
+                }
+            }
+            std::fclose(file);
+            return kb;
+        }
+
+        void reset_peak_rss() {
+            if (FILE* file = std::fopen("/proc/self/clear_refs", "w")) {
+                std::fputs("5", file);
+                std::fclose(file);
+            }
+        }
+    } // namespace
+
+    namespace detail {
+        void on_alloc(void* p) {
+            if (!counting.load(std::memory_order_relaxed)) return;
+            const long long size = block_size(p);
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+            const long long live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+            long long peak = peak_live_bytes.load(std::memory_order_relaxed);
+            while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        }
+
+        void on_free(void* p) {
+            if (!p || !counting.load(std::memory_order_relaxed)) return;
+            live_bytes.fetch_sub(block_size(p), std::memory_order_relaxed);
+        }
+    } // namespace detail
+
+    Scope::Scope() {
+        reset_peak_rss();
+        rss0_kb_ = status_kb("VmRSS");
+        allocations0_ = allocations.load();
+        bytes0_ = allocated_bytes.load();
+        live0_ = live_bytes.load();
+        peak_live_bytes.store(live0_);
+        counting.store(true);
+    }
+
+    Scope::~Scope() {
+        if (open_) counting.store(false);
+    }
+
+    Usage Scope::finish() {
+        counting.store(false);
+        open_ = false;
+        Usage usage;
+        usage.allocations = allocations.load() - allocations0_;
+        usage.bytes = allocated_bytes.load() - bytes0_;
+        usage.peak_live_bytes = std::max(0LL, peak_live_bytes.load() - live0_);
+        usage.peak_rss_kb = std::max(0LL, status_kb("VmHWM") - rss0_kb_);
+        return usage;
+    }
+} // namespace memory_stats
+
+// Replacements of the global allocation functions. Aligned overloads keep their
+// library versions and are not counted; nothing in this program over-aligns.
+namespace {
+    void* counted_alloc(std::size_t size) {
+        if (size == 0) size = 1;
+        void* p;
+        while (!(p = std::malloc(size))) {
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+        memory_stats::detail::on_alloc(p);
+        return p;
+    }
+
+    void* counted_alloc_nothrow(std::size_t size) noexcept {
+        try {
+            return counted_alloc(size);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void counted_free(void* p) noexcept {
+        memory_stats::detail::on_free(p);
+        std::free(p);
+    }
+} // namespace
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc_nothrow(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc_nothrow(size); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
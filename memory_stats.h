@@ -0,0 +1,41 @@
+#ifndef SMALLCPPPROGRAM_MEMORY_STATS_H
+#define SMALLCPPPROGRAM_MEMORY_STATS_H
+
+namespace memory_stats {
+
+// Heap and resident memory used by one measured phase.
+struct Usage {
+    long long allocations = 0;     // operator new calls
+    long long bytes = 0;           // bytes they returned
+    long long peak_live_bytes = 0; // highest heap growth above the start of the phase
+    long long peak_rss_kb = 0;     // VmHWM above VmRSS at the start, 0 when /proc is unavailable
+};
+
+/**
+ * @brief Accounts heap use between construction and finish().
+ *
+ * Counting is done by the global operator new/delete of memory_stats.cpp and is
+ * only switched on while a scope is open, so runs without memory accounting pay
+ * one relaxed load per allocation. Scopes must not overlap. The peak RSS uses
+ * /proc/self/clear_refs to restart VmHWM, which needs Linux 4.0 or later; the
+ * process-wide peak is reported otherwise.
+ */
+class Scope {
+public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // Usage since construction; counting stops here.
+    Usage finish();
+
+private:
+    long long allocations0_, bytes0_, live0_, rss0_kb_;
+    bool open_ = true;
+};
+
+} // namespace memory_stats
+
+#endif //SMALLCPPPROGRAM_MEMORY_STATS_H
@@ -0,0 +1,49 @@
+#ifndef SMALLCPPPROGRAM_MICROBENCH_HARNESS_H
+#define SMALLCPPPROGRAM_MICROBENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace microbench {
+
+// Keeps a computed value alive without the optimiser dropping the work behind it.
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Best time per operation over several rounds, in nanoseconds.
+ *
+ * Each round calls prepare() untimed, then times run(), which performs `ops`
+ * operations. Taking the best round filters out preemption and frequency ramp-up.
+ */
+template <typename Prepare, typename Run>
+double best_ns_per_op(const size_t ops, const int rounds, Prepare&& prepare, Run&& run) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int r = 0; r < rounds; ++r) {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / ops);
+    }
+    return best;
+}
+
+inline void print_row(const std::string& suite, const std::string& name, const size_t size, const double ns) {
+    std::cout << suite << "\t" << name << "\t" << size << "\t" << std::fixed << std::setprecision(2) << ns << "\n";
+}
+
+inline void print_header() {
+    std::cout << "Suite\tCase\tSize\tns_per_op\n";
+}
+
+} // namespace microbench
+
+#endif //SMALLCPPPROGRAM_MICROBENCH_HARNESS_H
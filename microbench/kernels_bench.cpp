@@ -0,0 +1,295 @@
+// Hot paths of the solvers, one suite each, at controlled sizes: the binary heaps of
+// dijkstra() and of bmssp's leaf Dijkstra, BlockingBasedHeap, single-edge relaxation,
+// building the graph and the bmssp CSR, and the generators. Inputs come from a fixed
+// seed except the generators', which seed themselves. Selection has its own binary,
+// select_bench.
+//
+// usage: kernels_bench [max_size] [suite ...]
+//        suites: heap, blocking_heap, relax, graph, generators (default: all)
+
+#include "bmssp.h"
+#include "graph_generators.h"
+#include "microbench/harness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Key = PackedDist<double>;
+
+constexpr int rounds = 5;
+constexpr int out_degree = 8;
+
+std::vector<Key> make_keys(const size_t n, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> dist(0.0, 1000.0);
+    std::vector<Key> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        const int vertex = static_cast<int>(i);
+        keys[i] = Key(dist(rng), static_cast<int>(rng() % 64), vertex, static_cast<int>(rng() % n));
+    }
+    return keys;
+}
+
+// n vertices with out_degree random out-edges each, weights in [0, 1000).
+Graph make_graph(const int n, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> weight(0.0, 1000.0);
+    Graph graph(n);
+    for (int u = 0; u < n; ++u) {
+        for (int i = 0; i < out_degree; ++i) graph.add_edge(u, static_cast<int>(rng() % n), weight(rng));
+    }
+    return graph;
+}
+
+// dijkstra()'s std::priority_queue and boundedDijkstra()'s heap of packed keys; an
+// operation is one push or one pop.
+void heap_suite(const std::vector<size_t>& sizes, std::mt19937_64& rng) {
+    for (const size_t n : sizes) {
+        const std::vector<Key> keys = make_keys(n, rng);
+
+        using QueueElement = std::pair<double, int>;
+        std::uniform_real_distribution<double> dist(0.0, 1000.0);
+        std::vector<QueueElement> pairs;
+        for (const Key& k : keys) pairs.emplace_back(dist(rng), k.vertex());
+        microbench::print_row("heap", "priority_queue", n, microbench::best_ns_per_op(
+            2 * n, rounds, [] {},
+            [&] {
+                std::priority_queue<QueueElement, std::vector<QueueElement>, std::greater<>> pq;
+                for (const auto& p : pairs) pq.push(p);
+                while (!pq.empty()) {
+                    microbench::keep(pq.top().second);
+                    pq.pop();
+                }
+            }));
+
+        std::vector<Key> heap;
+        heap.reserve(n);
+        const auto later = std::greater<Key>();
+        microbench::print_row("heap", "packed_heap", n, microbench::best_ns_per_op(
+            2 * n, rounds, [&] { heap.clear(); },
+            [&] {
+                for (const Key& k : keys) {
+                    heap.push_back(k);
+                    std::push_heap(heap.begin(), heap.end(), later);
+                }
+                while (!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), later);
+                    microbench::keep(heap.back().pred);
+                    heap.pop_back();
+                }
+            }));
+    }
+}
+
+// One vertex per key. insert and pull time n keys through a heap of block size M;
+// batch_prepend hands them over in batches of 2M, each below the previous one, the
+// way bmsspRec returns its smaller vertices. Times are per key.
+void blocking_heap_suite(const std::vector<size_t>& sizes, std::mt19937_64& rng) {
+    const Key bound(INF, 0, 0, 0);
+    for (const size_t n : sizes) {
+        const std::vector<Key> keys = make_keys(n, rng);
+        BlockingHeapIndex index;
+        index.assign(1, static_cast<int>(n));
+        BlockingBasedHeap<Key> heap(index, 0);
+        std::vector<int> pulled;
+
+        for (const int M : {32, 1024}) {
+            if (static_cast<size_t>(M) >= n) continue;
+            const std::string m = "_M" + std::to_string(M);
+
+            microbench::print_row("blocking_heap", "insert" + m, n, microbench::best_ns_per_op(
+                n, rounds, [&] { heap.initialize(M, bound); },
+                [&] {
+                    for (const Key& k : keys) heap.insert(k);
+                }));
+
+            microbench::print_row("blocking_heap", "pull" + m, n, microbench::best_ns_per_op(
+                n, rounds,
+                [&] {
+                    heap.initialize(M, bound);
+                    for (const Key& k : keys) heap.insert(k);
+                },
+                [&] {
+                    while (heap.size() > 0) {
+                        microbench::keep(heap.pull(pulled));
+                        microbench::keep(pulled.size());
+                    }
+                }));
+
+            std::vector<Key> sorted = keys;
+            std::sort(sorted.begin(), sorted.end(), std::greater<Key>());
+            std::vector<std::vector<Key>> batches;
+            for (size_t i = 0; i < n; i += 2 * M) {
+                batches.emplace_back(sorted.begin() + i, sorted.begin() + std::min(n, i + 2 * M));
+            }
+            microbench::print_row("blocking_heap", "batch_prepend" + m, n, microbench::best_ns_per_op(
+                n, rounds, [&] { heap.initialize(M, bound); },
+                [&] {
+                    for (const auto& batch : batches) heap.batchPrepend(batch);
+                    microbench::keep(heap.size());
+                }));
+        }
+    }
+}
+
+// One pass over every edge from distances drawn at random, so about half of the
+// relaxations succeed. double_* is dijkstra()'s test on a double, over Graph::adj and
+// over the CSR; packed_csr is the leaf Dijkstra's, which builds and compares packed
+// keys. Times are per edge.
+void relax_suite(const std::vector<size_t>& sizes, std::mt19937_64& rng) {
+    for (const size_t n : sizes) {
+        const int vertices = static_cast<int>(n);
+        const Graph graph = make_graph(vertices, rng);
+        const size_t m = n * out_degree;
+
+        CsrAdjacency<double> csr;
+        csr.assign_offsets(std::vector<size_t>(n, out_degree));
+        for (int u = 0; u < vertices; ++u) {
+            for (size_t i = 0; i < graph.adj[u].size(); ++i) {
+                csr.edges[csr.offset[u] + i] = {graph.adj[u][i].to, graph.adj[u][i].weight};
+            }
+        }
+
+        std::uniform_real_distribution<double> start(0.0, 2000.0);
+        std::vector<double> initial(n);
+        for (auto& x : initial) x = start(rng);
+        std::vector<double> dist;
+        std::vector<int> pred(n), hops(n);
+        std::vector<uint64_t> dist_key(n);
+        const auto reset = [&] {
+            dist = initial;
+            for (size_t v = 0; v < n; ++v) {
+                pred[v] = static_cast<int>(v);
+                hops[v] = 0;
+                dist_key[v] = Key::encode(initial[v]);
+            }
+        };
+
+        microbench::print_row("relax", "double_adj", n, microbench::best_ns_per_op(
+            m, rounds, reset,
+            [&] {
+                for (int u = 0; u < vertices; ++u) {
+                    for (const auto& edge : graph.adj[u]) {
+                        if (dist[u] + edge.weight < dist[edge.to]) {
+                            dist[edge.to] = dist[u] + edge.weight;
+                            pred[edge.to] = u;
+                        }
+                    }
+                }
+                microbench::keep(dist[0]);
+            }));
+
+        microbench::print_row("relax", "double_csr", n, microbench::best_ns_per_op(
+            m, rounds, reset,
+            [&] {
+                for (int u = 0; u < vertices; ++u) {
+                    for (const auto& [v, w] : csr[u]) {
+                        if (dist[u] + w < dist[v]) {
+                            dist[v] = dist[u] + w;
+                            pred[v] = u;
+                        }
+                    }
+                }
+                microbench::keep(dist[0]);
+            }));
+
+        microbench::print_row("relax", "packed_csr", n, microbench::best_ns_per_op(
+            m, rounds, reset,
+            [&] {
+                for (int u = 0; u < vertices; ++u) {
+                    for (const auto& [v, w] : csr[u]) {
+                        const Key candidate(dist[u] + w, hops[u] + 1, v, u);
+                        if (candidate <= Key::fromKey(dist_key[v], hops[v], v, pred[v])) {
+                            pred[v] = u;
+                            dist[v] = dist[u] + w;
+                            dist_key[v] = candidate.dist;
+                            hops[v] = hops[u] + 1;
+                        }
+                    }
+                }
+                microbench::keep(dist[0]);
+            }));
+    }
+}
+
+// Filling a Graph edge by edge, and BmsspPreparedGraph::build from it with and
+// without the constant-degree transformation. Times are per edge.
+void graph_suite(const std::vector<size_t>& sizes, std::mt19937_64& rng) {
+    for (const size_t n : sizes) {
+        const int vertices = static_cast<int>(n);
+        const Graph graph = make_graph(vertices, rng);
+        std::vector<std::tuple<int, int, double>> edges(graph.edges().begin(), graph.edges().end());
+        const size_t m = edges.size();
+
+        microbench::print_row("graph", "add_edge", n, microbench::best_ns_per_op(
+            m, rounds, [] {},
+            [&] {
+                Graph built(vertices);
+                for (const auto& [u, v, w] : edges) built.add_edge(u, v, w);
+                microbench::keep(built.adj.back().size());
+            }));
+
+        for (const bool constant_degree : {false, true}) {
+            microbench::print_row("graph", constant_degree ? "bmssp_prepare_cd" : "bmssp_prepare", n,
+                microbench::best_ns_per_op(
+                    m, rounds, [] {},
+                    [&] {
+                        const auto prepared = BmsspPreparedGraph<double>::build(graph.adj, vertices, constant_degree, {});
+                        microbench::keep(prepared->adj.edges.size());
+                    }));
+        }
+    }
+}
+
+// The generators the sweeps use most, per generated vertex. gen_random_graph walks
+// all n(n - 1) vertex pairs, so it stops at 4096 vertices.
+void generators_suite(const std::vector<size_t>& sizes) {
+    using namespace generators;
+    const auto time_generator = [](const std::string& name, const size_t n, const std::function<Graph()>& generate) {
+        microbench::print_row("generators", name, n, microbench::best_ns_per_op(
+            n, 3, [] {},
+            [&] { microbench::keep(generate().adj.size()); }));
+    };
+    for (const size_t n : sizes) {
+        const int vertices = static_cast<int>(n);
+        const int side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(n))));
+        time_generator("tree", n, [&] { return gen_tree(vertices, true, 4); });
+        time_generator("grid", static_cast<size_t>(side) * side, [&] { return gen_grid(side, side, true); });
+        time_generator("planar", n, [&] { return gen_planar(vertices, 0.5, true); });
+        if (n <= 4096) {
+            time_generator("random", n, [&] {
+                return gen_random_graph(vertices, static_cast<double>(out_degree) / vertices, 1,
+                                        CycleType::PositiveCycles, ConnectivityType::WeaklyConnected, true);
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t max_size = argc > 1 ? std::stoul(argv[1]) : (1 << 16);
+    std::vector<std::string> suites(argv + std::min(argc, 2), argv + argc);
+    const auto wanted = [&](const std::string& suite) {
+        return suites.empty() || std::find(suites.begin(), suites.end(), suite) != suites.end();
+    };
+    std::vector<size_t> sizes;
+    for (size_t n = 1024; n <= max_size; n *= 4) sizes.push_back(n);
+
+    std::mt19937_64 rng(12345);
+    microbench::print_header();
+    if (wanted("heap")) heap_suite(sizes, rng);
+    if (wanted("blocking_heap")) blocking_heap_suite(sizes, rng);
+    if (wanted("relax")) relax_suite(sizes, rng);
+    if (wanted("graph")) graph_suite(sizes, rng);
+    if (wanted("generators")) generators_suite(sizes);
+    return 0;
+}
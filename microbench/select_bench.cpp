@@ -0,0 +1,100 @@
+// Selection kernels at the sizes BlockingBasedHeap sees: pull() selects rank M out of
+// up to ~2M candidates, split() and batchPrepend() take medians. Elements are timed as
+// the heap stores them, (vertex, PackedDist) pairs, and as bare 64-bit keys.
+//
+// usage: select_bench [max_size]
+
+#include "bmssp.h"
+#include "microbench/harness.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Key = PackedDist<double>;
+using Element = std::pair<int, Key>;
+
+template <typename T>
+struct KeyLess;
+
+template <>
+struct KeyLess<Element> {
+    bool operator()(const Element& a, const Element& b) const { return a.second < b.second; }
+};
+
+template <>
+struct KeyLess<uint64_t> {
+    bool operator()(const uint64_t a, const uint64_t b) const { return a < b; }
+};
+
+std::vector<Element> make_elements(const size_t n, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> dist(0.0, 1000.0);
+    std::vector<Element> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        const int vertex = static_cast<int>(i);
+        v[i] = {vertex, Key(dist(rng), static_cast<int>(rng() % 64), vertex, static_cast<int>(rng() % n))};
+    }
+    return v;
+}
+
+std::vector<uint64_t> make_keys(const size_t n, std::mt19937_64& rng) {
+    std::vector<uint64_t> v(n);
+    for (auto& x : v) x = rng();
+    return v;
+}
+
+// Times selecting the median of `batch` independent arrays of size n per round.
+template <typename T, typename Select>
+double time_select(const std::vector<T>& source, const size_t n, Select&& select) {
+    const size_t batch = std::max<size_t>(1, (1 << 20) / n);
+    std::vector<T> work(batch * n);
+    return microbench::best_ns_per_op(
+        batch, 7,
+        [&] {
+            for (size_t b = 0; b < batch; ++b) std::copy(source.begin(), source.begin() + n, work.begin() + b * n);
+        },
+        [&] {
+            for (size_t b = 0; b < batch; ++b) {
+                auto first = work.begin() + b * n;
+                select(first, first + n / 2, first + n, KeyLess<T>());
+                microbench::keep(first[n / 2]);
+            }
+        });
+}
+
+template <typename T>
+void run_suite(const std::string& suite, const std::vector<T>& source, const std::vector<size_t>& sizes) {
+    for (const size_t n : sizes) {
+        auto fr = [](auto f, auto m, auto l, auto c) { floyd_rivest_select(f, m, l, c); };
+        auto nth = [](auto f, auto m, auto l, auto c) { std::nth_element(f, m, l, c); };
+        auto branchless = [](auto f, auto m, auto l, auto c) { branchless_select(f, m, l, c); };
+        microbench::print_row(suite, "floyd_rivest", n, time_select(source, n, fr));
+        microbench::print_row(suite, "nth_element", n, time_select(source, n, nth));
+        microbench::print_row(suite, "branchless", n, time_select(source, n, branchless));
+
+        // the sample cutoff only matters above it
+        if (n > 200) {
+            auto fr200 = [](auto f, auto m, auto l, auto c) { floyd_rivest_select<decltype(f), decltype(c), 200>(f, m, l, c); };
+            auto fr2400 = [](auto f, auto m, auto l, auto c) { floyd_rivest_select<decltype(f), decltype(c), 2400>(f, m, l, c); };
+            microbench::print_row(suite, "floyd_rivest_q200", n, time_select(source, n, fr200));
+            microbench::print_row(suite, "floyd_rivest_q2400", n, time_select(source, n, fr2400));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t max_size = argc > 1 ? std::stoul(argv[1]) : (1 << 16);
+    std::vector<size_t> sizes;
+    for (size_t n = 16; n <= max_size; n *= 4) sizes.push_back(n);
+
+    std::mt19937_64 rng(12345);
+    microbench::print_header();
+    run_suite("select_pair", make_elements(max_size, rng), sizes);
+    run_suite("select_key", make_keys(max_size, rng), sizes);
+    return 0;
+}
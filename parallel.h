@@ -0,0 +1,167 @@
+#ifndef SMALLCPPPROGRAM_PARALLEL_H
+#define SMALLCPPPROGRAM_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace parallel {
+
+namespace detail {
+inline bool& run_inline() {
+    thread_local bool on = false;
+    return on;
+}
+} // namespace detail
+
+/**
+ * @brief While alive, pool runs started by this thread execute on it alone.
+ *
+ * Used by jobs that run side by side on pinned cores: each one keeps its work on
+ * its own CPU instead of queueing on the shared default_pool().
+ */
+class InlineScope {
+public:
+    InlineScope() : saved_(detail::run_inline()) { detail::run_inline() = true; }
+    ~InlineScope() { detail::run_inline() = saved_; }
+
+    InlineScope(const InlineScope&) = delete;
+    InlineScope& operator=(const InlineScope&) = delete;
+
+private:
+    bool saved_;
+};
+
+/**
+ * @brief Persistent fork-join pool.
+ *
+ * run() hands tasks [0, tasks) to the workers and the calling thread, and returns
+ * once all of them are done. Workers sleep between runs, so a run costs one wake-up
+ * rather than a thread creation. They start with the first run that needs them, so a
+ * process whose runs all stay inline never has more than one thread, which
+ * isolation::run_isolated relies on. Tasks must not throw.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(const int threads) : threads_(std::max(threads, 1)) {}
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 1 inside an InlineScope, so callers sizing their split by it do not over-partition.
+    [[nodiscard]] int size() const { return detail::run_inline() ? 1 : threads_; }
+
+    template <typename Fn>
+    void run(const int tasks, Fn&& fn) {
+        if (tasks <= 0) return;
+        if (tasks == 1 || threads_ == 1 || detail::run_inline()) {
+            for (int i = 0; i < tasks; ++i) fn(i);
+            return;
+        }
+
+        using FnT = std::remove_reference_t<Fn>;
+        std::lock_guard<std::mutex> run_lock(run_mutex_); // one run at a time
+        if (workers_.empty()) {
+            for (int i = 1; i < threads_; ++i) workers_.emplace_back([this] { worker_loop(); });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ctx_ = const_cast<void*>(static_cast<const void*>(&fn));
+            job_call_ = [](void* ctx, int i) { (*static_cast<FnT*>(ctx))(i); };
+            tasks_ = tasks;
+            next_.store(0, std::memory_order_relaxed);
+            running_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return running_ == 0; });
+    }
+
+private:
+    void drain() {
+        int i;
+        while ((i = next_.fetch_add(1, std::memory_order_relaxed)) < tasks_) {
+            job_call_(job_ctx_, i);
+        }
+    }
+
+    void worker_loop() {
+        unsigned long long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            drain();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--running_ == 0) done_.notify_one();
+            }
+        }
+    }
+
+    const int threads_; // workers plus the calling thread
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    bool stop_ = false;
+    unsigned long long generation_ = 0;
+    int running_ = 0;
+
+    void* job_ctx_ = nullptr;
+    void (*job_call_)(void*, int) = nullptr;
+    int tasks_ = 0;
+    std::atomic<int> next_{0};
+};
+
+inline ThreadPool& default_pool() {
+    static ThreadPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
+
+/**
+ * @brief Splits [0, n) into contiguous chunks and calls fn(begin, end) for each one.
+ *
+ * Chunks hold at least `grain` items, so small inputs stay on the calling thread.
+ */
+template <typename Fn>
+void for_chunks(const size_t n, Fn&& fn, const size_t grain = 1 << 14) {
+    if (n == 0) return;
+    auto& pool = default_pool();
+    const size_t chunks = std::max<size_t>(1, std::min<size_t>(pool.size(), n / std::max<size_t>(grain, 1)));
+    if (chunks == 1) {
+        fn(size_t{0}, n);
+        return;
+    }
+    pool.run(static_cast<int>(chunks), [&](const int c) {
+        const size_t begin = n * c / chunks;
+        const size_t end = n * (c + 1) / chunks;
+        fn(begin, end);
+    });
+}
+
+} // namespace parallel
+
+#endif //SMALLCPPPROGRAM_PARALLEL_H
@@ -0,0 +1,182 @@
+#ifndef SMALLCPPPROGRAM_PERF_COUNTERS_H
+#define SMALLCPPPROGRAM_PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf {
+
+enum Event { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, DtlbMisses, EventCount };
+
+// Column names of the benchmark TSV, in Event order.
+inline const char* event_name(const int e) {
+    static const char* const names[EventCount] = {
+        "Cycles", "Instructions", "L1D_misses", "LLC_misses", "BranchMisses", "dTLB_misses"};
+    return names[e];
+}
+
+// Counts of one measured interval; events the kernel refused stay invalid.
+struct Sample {
+    std::array<double, EventCount> value{};
+    std::array<bool, EventCount> valid{};
+};
+
+/**
+ * @brief Hardware counters of the calling thread, opened as one perf_event group.
+ *
+ * The group is enabled, disabled and read together, so all events cover the same
+ * instructions. Events the PMU or kernel does not offer are skipped; if none opens
+ * (perf_event_paranoid, containers, non-Linux builds) available() is false and
+ * error() says why. Threads other than the caller, such as parallel::default_pool()
+ * workers, are not counted.
+ */
+class CounterGroup {
+public:
+    CounterGroup() {
+        fd_.fill(-1);
+#if defined(__linux__)
+        for (int e = 0; e < EventCount; ++e) open_event(e);
+        if (leader_ < 0 && error_.empty()) error_ = "no hardware events available";
+#else
+        error_ = "perf_event_open is only available on Linux";
+#endif
+    }
+
+    ~CounterGroup() {
+#if defined(__linux__)
+        for (int fd : fd_) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    CounterGroup(const CounterGroup&) = delete;
+    CounterGroup& operator=(const CounterGroup&) = delete;
+
+    [[nodiscard]] bool available() const { return leader_ >= 0; }
+    [[nodiscard]] const std::string& error() const { return error_; }
+
+    void start() {
+#if defined(__linux__)
+        if (!available()) return;
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Counts since start(), scaled up when the kernel multiplexed the group.
+    Sample stop() {
+        Sample sample;
+#if defined(__linux__)
+        if (!available()) return sample;
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // PERF_FORMAT_GROUP | ID | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING layout
+        struct {
+            uint64_t nr, time_enabled, time_running;
+            struct {
+                uint64_t value, id;
+            } values[EventCount];
+        } data{};
+        if (read(leader_, &data, sizeof(data)) <= 0 || data.time_running == 0) return sample;
+
+        const double scale = static_cast<double>(data.time_enabled) / data.time_running;
+        for (uint64_t i = 0; i < data.nr && i < EventCount; ++i) {
+            for (int e = 0; e < EventCount; ++e) {
+                if (fd_[e] >= 0 && id_[e] == data.values[i].id) {
+                    sample.value[e] = static_cast<double>(data.values[i].value) * scale;
+                    sample.valid[e] = true;
+                }
+            }
+        }
+#endif
+        return sample;
+    }
+
+private:
+#if defined(__linux__)
+    static uint64_t cache_event(const uint64_t cache, const uint64_t op, const uint64_t result) {
+        return cache | (op << 8) | (result << 16);
+    }
+
+    void open_event(const int e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch (e) {
+            case Cycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case Instructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case L1dMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                          PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case LlcMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case DtlbMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                          PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            default:
+                return;
+        }
+        attr.disabled = leader_ < 0 ? 1 : 0; // members follow the leader
+        attr.exclude_kernel = 1;             // allowed at perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+        if (fd < 0) {
+            const int err = errno;
+            if (leader_ < 0 && error_.empty()) {
+                error_ = std::string("perf_event_open: ") + std::strerror(err);
+                if (err == EACCES || err == EPERM) error_ += " (check /proc/sys/kernel/perf_event_paranoid)";
+                else if (err == ENOENT || err == EOPNOTSUPP) error_ += " (no PMU exposed, e.g. inside a VM)";
+            }
+            return;
+        }
+        if (ioctl(fd, PERF_EVENT_IOC_ID, &id_[e]) != 0) {
+            close(fd);
+            return;
+        }
+        fd_[e] = fd;
+        if (leader_ < 0) {
+            leader_ = fd;
+            error_.clear();
+        }
+    }
+#endif
+
+    std::array<int, EventCount> fd_{};
+    std::array<uint64_t, EventCount> id_{};
+    int leader_ = -1;
+    std::string error_;
+};
+
+} // namespace perf
+
+#endif //SMALLCPPPROGRAM_PERF_COUNTERS_H
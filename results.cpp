@@ -0,0 +1,716 @@
+#include "results.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "complexity.h"
+#include "runner.h"
+#include "sample_stats.h"
+
+#if defined(__linux__)
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+#ifndef SMALLCPP_GIT_COMMIT
+#define SMALLCPP_GIT_COMMIT "unknown"
+#endif
+
+namespace results {
+    namespace {
+        // Shortest text that reads back to the same double; JSON has no inf or NaN, so those become null.
+        std::string number(const double x) {
+            if (!std::isfinite(x)) return "null";
+            char buf[32];
+            const auto end = std::to_chars(buf, buf + sizeof(buf), x).ptr;
+            return std::string(buf, end);
+        }
+
+        std::string json_string(const std::string& s) {
+            std::string out = "\"";
+            for (const char c : s) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\r': out += "\\r"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buf[8];
+                            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                            out += buf;
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            return out + "\"";
+        }
+
+        std::string status_of(const Row& row) {
+            if (!row.status.empty()) return row.status;
+            return row.result.success ? "ok" : "error";
+        }
+
+        std::string csv_field(const std::string& s) {
+            if (s.find_first_of(",\"\n") == std::string::npos) return s;
+            std::string out = "\"";
+            for (const char c : s) {
+                if (c == '"') out += '"';
+                out += c;
+            }
+            return out + "\"";
+        }
+
+        std::string key_values(const std::vector<std::pair<std::string, double>>& values) {
+            std::string out;
+            for (const auto& [key, value] : values) out += (out.empty() ? "" : ";") + key + "=" + number(value);
+            return out;
+        }
+
+        std::string first_line_of(const std::string& path, const std::string& key) {
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.rfind(key, 0) != 0) continue;
+                const size_t colon = line.find(':');
+                if (colon == std::string::npos) continue;
+                const size_t start = line.find_first_not_of(" \t", colon + 1);
+                return start == std::string::npos ? "" : line.substr(start);
+            }
+            return "";
+        }
+
+        // Minimal JSON tree, enough to read back write_json output.
+        struct Json {
+            enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+            bool boolean = false;
+            double num = 0.0;
+            std::string str;
+            std::vector<Json> items;
+            std::vector<std::pair<std::string, Json>> members;
+
+            [[nodiscard]] const Json* find(const std::string& key) const {
+                for (const auto& [k, v] : members) {
+                    if (k == key) return &v;
+                }
+                return nullptr;
+            }
+            [[nodiscard]] double number_or(const std::string& key, const double fallback) const {
+                const Json* v = find(key);
+                return v && v->type == Number ? v->num : fallback;
+            }
+            [[nodiscard]] std::string string_or(const std::string& key, const std::string& fallback) const {
+                const Json* v = find(key);
+                return v && v->type == String ? v->str : fallback;
+            }
+        };
+
+        class JsonParser {
+        public:
+            explicit JsonParser(const std::string& text) : s_(text) {}
+
+            Json parse() {
+                Json value = value_();
+                skip_space();
+                if (pos_ != s_.size()) fail("trailing characters");
+                return value;
+            }
+
+        private:
+            [[noreturn]] void fail(const std::string& what) const {
+                throw std::runtime_error("JSON: " + what + " at offset " + std::to_string(pos_));
+            }
+
+            void skip_space() {
+                while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\n' || s_[pos_] == '\t' || s_[pos_] == '\r')) ++pos_;
+            }
+
+            bool consume(const char c) {
+                skip_space();
+                if (pos_ < s_.size() && s_[pos_] == c) {
+                    ++pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(const char c) {
+                if (!consume(c)) fail(std::string("expected '") + c + "'");
+            }
+
+            bool literal(const char* word) {
+                const std::string w(word);
+                if (s_.compare(pos_, w.size(), w) != 0) return false;
+                pos_ += w.size();
+                return true;
+            }
+
+            Json value_() {
+                skip_space();
+                if (pos_ >= s_.size()) fail("unexpected end");
+                Json v;
+                const char c = s_[pos_];
+                if (c == '{') {
+                    ++pos_;
+                    v.type = Json::Object;
+                    if (consume('}')) return v;
+                    do {
+                        skip_space();
+                        std::string key = string_();
+                        expect(':');
+                        v.members.emplace_back(std::move(key), value_());
+                    } while (consume(','));
+                    expect('}');
+                } else if (c == '[') {
+                    ++pos_;
+                    v.type = Json::Array;
+                    if (consume(']')) return v;
+                    do {
+                        v.items.push_back(value_());
+                    } while (consume(','));
+                    expect(']');
+                } else if (c == '"') {
+                    v.type = Json::String;
+                    v.str = string_();
+                } else if (literal("true")) {
+                    v.type = Json::Bool;
+                    v.boolean = true;
+                } else if (literal("false")) {
+                    v.type = Json::Bool;
+                } else if (literal("null")) {
+                    v.type = Json::Null;
+                } else {
+                    v.type = Json::Number;
+                    const auto [end, ec] = std::from_chars(s_.data() + pos_, s_.data() + s_.size(), v.num);
+                    if (ec != std::errc()) fail("bad value");
+                    pos_ = static_cast<size_t>(end - s_.data());
+                }
+                return v;
+            }
+
+            std::string string_() {
+                if (pos_ >= s_.size() || s_[pos_] != '"') fail("expected string");
+                ++pos_;
+                std::string out;
+                while (pos_ < s_.size() && s_[pos_] != '"') {
+                    char c = s_[pos_++];
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+                    if (pos_ >= s_.size()) break;
+                    c = s_[pos_++];
+                    switch (c) {
+                        case 'n': out += '\n'; break;
+                        case 't': out += '\t'; break;
+                        case 'r': out += '\r'; break;
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        case 'u': {
+                            if (pos_ + 4 > s_.size()) fail("bad escape");
+                            const unsigned code = static_cast<unsigned>(std::stoul(s_.substr(pos_, 4), nullptr, 16));
+                            pos_ += 4;
+                            if (code < 0x80) {
+                                out += static_cast<char>(code);
+                            } else if (code < 0x800) {
+                                out += static_cast<char>(0xC0 | (code >> 6));
+                                out += static_cast<char>(0x80 | (code & 0x3F));
+                            } else {
+                                out += static_cast<char>(0xE0 | (code >> 12));
+                                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                                out += static_cast<char>(0x80 | (code & 0x3F));
+                            }
+                            break;
+                        }
+                        default: out += c; // \" \\ \/
+                    }
+                }
+                if (pos_ >= s_.size()) fail("unterminated string");
+                ++pos_;
+                return out;
+            }
+
+            const std::string& s_;
+            size_t pos_ = 0;
+        };
+
+        std::vector<std::pair<std::string, double>> key_values_of(const Json* object) {
+            std::vector<std::pair<std::string, double>> values;
+            if (!object) return values;
+            for (const auto& [key, v] : object->members) {
+                if (v.type == Json::Number) values.emplace_back(key, v.num);
+            }
+            return values;
+        }
+
+        const char* const memory_fields[] = {"allocations", "bytes", "peak_live_bytes", "peak_rss_kb"};
+
+        std::array<long long, 4> memory_values(const memory_stats::Usage& u) {
+            return {u.allocations, u.bytes, u.peak_live_bytes, u.peak_rss_kb};
+        }
+
+        memory_stats::Usage memory_usage(const Json* o) {
+            memory_stats::Usage u;
+            if (!o) return u;
+            u.allocations = static_cast<long long>(o->number_or(memory_fields[0], 0));
+            u.bytes = static_cast<long long>(o->number_or(memory_fields[1], 0));
+            u.peak_live_bytes = static_cast<long long>(o->number_or(memory_fields[2], 0));
+            u.peak_rss_kb = static_cast<long long>(o->number_or(memory_fields[3], 0));
+            return u;
+        }
+
+        Row row_of(const Json& r) {
+            Row row;
+            row.experiment = r.string_or("experiment", "");
+            row.generator = r.string_or("generator", "");
+            row.graph = r.string_or("graph", "");
+            row.algorithm = r.string_or("algorithm", "");
+            row.edges = static_cast<long long>(r.number_or("edges", 0));
+            row.cpu = static_cast<int>(r.number_or("cpu", -1));
+            row.governor = r.string_or("governor", "");
+            row.valid = r.string_or("valid", "");
+            BenchmarkResult& res = row.result;
+            res.algorithm_name = row.algorithm;
+            res.vertices = static_cast<int>(r.number_or("vertices", 0));
+            const Json* success = r.find("success");
+            res.success = success && success->boolean;
+            res.error_msg = r.string_or("error", "");
+            row.status = r.string_or("status", res.success ? "ok" : "error");
+            res.iterations = static_cast<int>(r.number_or("iterations", 0));
+            res.avg_time_ms = r.number_or("mean_ms", 0);
+            res.min_time_ms = r.number_or("min_ms", 0);
+            res.max_time_ms = r.number_or("max_ms", 0);
+            res.std_dev_ms = r.number_or("std_dev_ms", 0);
+            res.median_ms = r.number_or("median_ms", 0);
+            res.p90_ms = r.number_or("p90_ms", 0);
+            res.p99_ms = r.number_or("p99_ms", 0);
+            res.ci_low_ms = r.number_or("ci95_low_ms", 0);
+            res.ci_high_ms = r.number_or("ci95_high_ms", 0);
+            res.outliers = static_cast<int>(r.number_or("outliers", 0));
+            if (const Json* phases = r.find("phases_ms")) {
+                for (int p = 0; p < kPhaseCount; ++p) res.phase_ms[p] = phases->number_or(phase_name(static_cast<Phase>(p)), 0);
+            }
+            res.sources = static_cast<int>(r.number_or("sources", 1));
+            res.qps = r.number_or("qps", 0);
+            res.metrics = key_values_of(r.find("metrics"));
+            res.counters = key_values_of(r.find("counters"));
+            if (const Json* memory = r.find("memory")) {
+                res.memory_measured = true;
+                res.query_memory = memory_usage(memory->find("query"));
+                if (const Json* prep = memory->find("preprocessing")) {
+                    res.has_preprocessing = true;
+                    res.preprocessing_memory = memory_usage(prep);
+                }
+            }
+            if (const Json* samples = r.find("samples_ms")) {
+                for (const Json& s : samples->items) res.samples_ms.push_back(s.type == Json::Number ? s.num : NAN);
+            }
+            if (const Json* sources = r.find("sample_sources")) {
+                for (const Json& s : sources->items) res.sample_sources.push_back(static_cast<int>(s.num));
+            }
+            return row;
+        }
+
+        void write_row(std::ostream& out, const Row& row) {
+            const BenchmarkResult& res = row.result;
+            const auto object = [&](const std::vector<std::pair<std::string, double>>& values) {
+                std::string o = "{";
+                for (size_t i = 0; i < values.size(); ++i) {
+                    o += (i ? ", " : "") + json_string(values[i].first) + ": " + number(values[i].second);
+                }
+                return o + "}";
+            };
+            out << "{"
+                << "\"experiment\": " << json_string(row.experiment)
+                << ", \"generator\": " << json_string(row.generator)
+                << ", \"graph\": " << json_string(row.graph)
+                << ", \"vertices\": " << res.vertices
+                << ", \"edges\": " << row.edges
+                << ", \"algorithm\": " << json_string(row.algorithm)
+                << ", \"success\": " << (res.success ? "true" : "false")
+                << ", \"status\": " << json_string(status_of(row));
+            if (!res.success) {
+                out << ", \"error\": " << json_string(res.error_msg) << ", \"cpu\": " << row.cpu << "}";
+                return;
+            }
+            out << ", \"iterations\": " << res.iterations
+                << ", \"mean_ms\": " << number(res.avg_time_ms)
+                << ", \"min_ms\": " << number(res.min_time_ms)
+                << ", \"max_ms\": " << number(res.max_time_ms)
+                << ", \"std_dev_ms\": " << number(res.std_dev_ms)
+                << ", \"median_ms\": " << number(res.median_ms)
+                << ", \"p90_ms\": " << number(res.p90_ms)
+                << ", \"p99_ms\": " << number(res.p99_ms)
+                << ", \"ci95_low_ms\": " << number(res.ci_low_ms)
+                << ", \"ci95_high_ms\": " << number(res.ci_high_ms)
+                << ", \"outliers\": " << res.outliers;
+            std::vector<std::pair<std::string, double>> phases;
+            for (int p = 0; p < kPhaseCount; ++p) phases.emplace_back(phase_name(static_cast<Phase>(p)), res.phase_ms[p]);
+            out << ", \"phases_ms\": " << object(phases)
+                << ", \"sources\": " << res.sources
+                << ", \"qps\": " << number(res.qps)
+                << ", \"cpu\": " << row.cpu
+                << ", \"governor\": " << json_string(row.governor);
+            if (!row.valid.empty()) out << ", \"valid\": " << json_string(row.valid);
+            out << ", \"metrics\": " << object(res.metrics);
+            if (!res.counters.empty()) out << ", \"counters\": " << object(res.counters);
+            if (res.memory_measured) {
+                const auto usage = [&](const memory_stats::Usage& u) {
+                    const auto fields = memory_values(u);
+                    std::vector<std::pair<std::string, double>> values;
+                    for (int i = 0; i < 4; ++i) values.emplace_back(memory_fields[i], static_cast<double>(fields[i]));
+                    return object(values);
+                };
+                out << ", \"memory\": {\"query\": " << usage(res.query_memory);
+                if (res.has_preprocessing) out << ", \"preprocessing\": " << usage(res.preprocessing_memory);
+                out << "}";
+            }
+            out << ", \"samples_ms\": [";
+            for (size_t i = 0; i < res.samples_ms.size(); ++i) out << (i ? ", " : "") << number(res.samples_ms[i]);
+            out << "], \"sample_sources\": [";
+            for (size_t i = 0; i < res.sample_sources.size(); ++i) out << (i ? ", " : "") << res.sample_sources[i];
+            out << "]}";
+        }
+
+        // Every CSV column of a row as (header, cell), so the header and the rows come from one list.
+        // Failed rows leave the measurements empty.
+        std::vector<std::pair<std::string, std::string>> csv_cells(const Row& row) {
+            const BenchmarkResult& res = row.result;
+            const bool ok = res.success;
+            std::vector<std::pair<std::string, std::string>> cells;
+            const auto add = [&](std::string name, std::string value) { cells.emplace_back(std::move(name), std::move(value)); };
+            const auto measured = [&](std::string name, std::string value) { add(std::move(name), ok ? std::move(value) : ""); };
+
+            add("experiment", csv_field(row.experiment));
+            add("generator", csv_field(row.generator));
+            add("graph", csv_field(row.graph));
+            add("vertices", std::to_string(res.vertices));
+            add("edges", std::to_string(row.edges));
+            add("algorithm", csv_field(row.algorithm));
+            add("success", ok ? "true" : "false");
+            add("status", status_of(row));
+            add("error", csv_field(ok ? "" : res.error_msg));
+            measured("iterations", std::to_string(res.iterations));
+            measured("mean_ms", number(res.avg_time_ms));
+            measured("min_ms", number(res.min_time_ms));
+            measured("max_ms", number(res.max_time_ms));
+            measured("std_dev_ms", number(res.std_dev_ms));
+            measured("median_ms", number(res.median_ms));
+            measured("p90_ms", number(res.p90_ms));
+            measured("p99_ms", number(res.p99_ms));
+            measured("ci95_low_ms", number(res.ci_low_ms));
+            measured("ci95_high_ms", number(res.ci_high_ms));
+            measured("outliers", std::to_string(res.outliers));
+            for (int p = 0; p < kPhaseCount; ++p) {
+                measured(std::string(phase_name(static_cast<Phase>(p))) + "_ms", number(res.phase_ms[p]));
+            }
+            measured("sources", std::to_string(res.sources));
+            measured("qps", number(res.qps));
+            add("cpu", std::to_string(row.cpu));
+            measured("governor", csv_field(row.governor));
+            measured("valid", csv_field(row.valid));
+            measured("metrics", csv_field(key_values(res.metrics)));
+            measured("counters", csv_field(key_values(res.counters)));
+            for (const bool prep : {true, false}) {
+                const auto fields = memory_values(prep ? res.preprocessing_memory : res.query_memory);
+                const bool has = ok && res.memory_measured && (!prep || res.has_preprocessing);
+                for (int i = 0; i < 4; ++i) {
+                    add(std::string(prep ? "prep_" : "query_") + memory_fields[i], has ? std::to_string(fields[i]) : "");
+                }
+            }
+            return cells;
+        }
+    } // namespace
+
+    Environment collect_environment(const std::string& config_file) {
+        Environment env;
+        const std::time_t now = std::time(nullptr);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        env.emplace_back("timestamp", stamp);
+        env.emplace_back("git_commit", SMALLCPP_GIT_COMMIT);
+#if defined(__clang__)
+        env.emplace_back("compiler", std::string("clang ") + __clang_version__);
+#elif defined(__GNUC__)
+        env.emplace_back("compiler", std::string("gcc ") + __VERSION__);
+#elif defined(_MSC_VER)
+        env.emplace_back("compiler", "msvc " + std::to_string(_MSC_VER));
+#endif
+        env.emplace_back("cxx_standard", std::to_string(__cplusplus));
+#if defined(NDEBUG)
+        env.emplace_back("assertions", "off");
+#else
+        env.emplace_back("assertions", "on");
+#endif
+#if defined(__OPTIMIZE__)
+        env.emplace_back("optimized", "yes");
+#else
+        env.emplace_back("optimized", "no");
+#endif
+#if defined(__linux__)
+        char host[256] = {};
+        if (gethostname(host, sizeof(host) - 1) == 0) env.emplace_back("host", host);
+        utsname uts{};
+        if (uname(&uts) == 0) {
+            env.emplace_back("os", std::string(uts.sysname) + " " + uts.release);
+            env.emplace_back("arch", uts.machine);
+        }
+        env.emplace_back("cpu_model", first_line_of("/proc/cpuinfo", "model name"));
+#endif
+        env.emplace_back("logical_cpus", std::to_string(std::thread::hardware_concurrency()));
+        env.emplace_back("governor", runner::governor(runner::current_cpu()));
+        env.emplace_back("config", config_file);
+        return env;
+    }
+
+    std::string to_json(const Row& row) {
+        std::ostringstream out;
+        write_row(out, row);
+        return out.str();
+    }
+
+    void write_json(std::ostream& out, const Environment& env, const std::vector<Row>& rows) {
+        out << "{\n  \"environment\": {";
+        for (size_t i = 0; i < env.size(); ++i) {
+            out << (i ? "," : "") << "\n    " << json_string(env[i].first) << ": " << json_string(env[i].second);
+        }
+        out << "\n  },\n  \"results\": [";
+        for (size_t r = 0; r < rows.size(); ++r) {
+            out << (r ? "," : "") << "\n    ";
+            write_row(out, rows[r]);
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void write_csv(std::ostream& out, const Environment& env, const std::vector<Row>& rows) {
+        for (const auto& [key, value] : env) out << "# " << key << ": " << value << "\n";
+        const auto header = csv_cells(Row{});
+        for (size_t i = 0; i < header.size(); ++i) out << (i ? "," : "") << header[i].first;
+        out << "\n";
+        for (const Row& row : rows) {
+            const auto cells = csv_cells(row);
+            for (size_t i = 0; i < cells.size(); ++i) out << (i ? "," : "") << cells[i].second;
+            out << "\n";
+        }
+    }
+
+    std::vector<Row> load_json(const std::string& path, Environment* env) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open " + path);
+        std::stringstream text;
+        text << in.rdbuf();
+        const Json root = JsonParser(text.str()).parse();
+
+        if (env) {
+            env->clear();
+            if (const Json* e = root.find("environment")) {
+                for (const auto& [key, v] : e->members) env->emplace_back(key, v.str);
+            }
+        }
+
+        const Json* list = root.find("results");
+        if (!list || list->type != Json::Array) throw std::runtime_error(path + " has no results array");
+        std::vector<Row> rows;
+        for (const Json& r : list->items) {
+            rows.push_back(row_of(r));
+        }
+        return rows;
+    }
+
+    Row row_from_json(const std::string& text) {
+        return row_of(JsonParser(text).parse());
+    }
+
+    void report_environment_changes(const Environment& baseline, const Environment& current, std::ostream& report) {
+        for (const auto& [key, value] : current) {
+            if (key == "timestamp") continue;
+            for (const auto& [base_key, base_value] : baseline) {
+                if (base_key == key && base_value != value) {
+                    report << "# " << key << " differs: baseline '" << base_value << "', now '" << value << "'\n";
+                }
+            }
+        }
+    }
+
+    int compare(const std::vector<Row>& baseline, const std::vector<Row>& current,
+                const CompareOptions& options, std::ostream& report) {
+        using Key = std::tuple<std::string, std::string, int, std::string>;
+        const auto key_of = [](const Row& r) { return Key{r.experiment, r.graph, r.result.vertices, r.algorithm}; };
+        std::map<Key, const Row*> before;
+        for (const Row& r : baseline) before[key_of(r)] = &r;
+
+        int regressions = 0, improvements = 0, unchanged = 0, added = 0;
+        report << "Experiment\tGraph\tVertices\tAlgorithm\tBaseline_ms\tCurrent_ms\tChange\tp\tVerdict\n";
+        for (const Row& cur : current) {
+            const auto it = before.find(key_of(cur));
+            const Row* base = it == before.end() ? nullptr : it->second;
+            if (base) before.erase(it);
+
+            report << cur.experiment << "\t" << cur.graph << "\t" << cur.result.vertices << "\t" << cur.algorithm << "\t";
+            if (!base) {
+                report << "\t" << number(cur.result.median_ms) << "\t\t\tnew\n";
+                ++added;
+                continue;
+            }
+            report << number(base->result.median_ms) << "\t";
+            if (!cur.result.success || cur.valid.find("mismatch") != std::string::npos ||
+                cur.valid.find("triangle") != std::string::npos) {
+                const std::string status = status_of(cur);
+                report << "\t\t\t" << (cur.result.success ? "invalid" : status == "error" ? "failed" : status) << "\n";
+                ++regressions;
+                continue;
+            }
+            report << number(cur.result.median_ms) << "\t";
+            if (!base->result.success || base->result.median_ms <= 0) {
+                report << "\t\tunchanged\n";
+                ++unchanged;
+                continue;
+            }
+
+            const double change = cur.result.median_ms / base->result.median_ms - 1.0;
+            bool significant;
+            std::string p_cell = "-";
+            if (cur.result.samples_ms.size() >= 3 && base->result.samples_ms.size() >= 3) {
+                const double p = sample_stats::mann_whitney_p(base->result.samples_ms, cur.result.samples_ms);
+                significant = p < options.alpha;
+                std::ostringstream p_text;
+                p_text.precision(3);
+                p_text << p;
+                p_cell = p_text.str();
+            } else {
+                significant = cur.result.ci_low_ms > base->result.ci_high_ms || cur.result.ci_high_ms < base->result.ci_low_ms;
+            }
+
+            std::ostringstream change_text;
+            change_text.setf(std::ios::fixed | std::ios::showpos);
+            change_text.precision(1);
+            change_text << 100.0 * change << "%";
+            report << change_text.str() << "\t" << p_cell << "\t";
+            if (significant && change > options.threshold) {
+                report << "regression\n";
+                ++regressions;
+            } else if (significant && change < -options.threshold) {
+                report << "improvement\n";
+                ++improvements;
+            } else {
+                report << "unchanged\n";
+                ++unchanged;
+            }
+        }
+        for (const auto& [key, base] : before) {
+            report << base->experiment << "\t" << base->graph << "\t" << base->result.vertices << "\t" << base->algorithm
+                   << "\t" << number(base->result.median_ms) << "\t\t\t\tmissing\n";
+        }
+        report << "# " << regressions << " regressions, " << improvements << " improvements, " << unchanged
+               << " unchanged, " << added << " new, " << before.size() << " missing"
+               << " (threshold " << options.threshold * 100 << "%, alpha " << options.alpha << ")\n";
+        return regressions;
+    }
+    void write_complexity(std::ostream& out, const std::vector<Row>& rows) {
+        struct Series {
+            std::string experiment, algorithm;
+            std::vector<complexity::Point> points;
+            std::array<complexity::Fit, complexity::ModelCount> fits;
+            int best = -1;
+        };
+        std::vector<Series> series;
+        for (const Row& row : rows) {
+            if (!row.result.success || status_of(row) != "ok") continue;
+            auto it = std::find_if(series.begin(), series.end(), [&](const Series& s) {
+                return s.experiment == row.experiment && s.algorithm == row.algorithm;
+            });
+            if (it == series.end()) it = series.insert(series.end(), Series{row.experiment, row.algorithm, {}, {}, -1});
+            const double ms = row.result.median_ms > 0 ? row.result.median_ms : row.result.avg_time_ms;
+            it->points.push_back({static_cast<double>(row.result.vertices), static_cast<double>(row.edges), ms});
+        }
+
+        out << "Experiment\tAlgorithm\tModel\tPoints\tMinN\tMaxN\tExponent\tCoef_ns\tRmsErr_pct\tR2\tBest\n";
+        for (Series& s : series) {
+            double best_rms = 0;
+            for (int m = 0; m < complexity::ModelCount; ++m) {
+                s.fits[m] = complexity::fit(static_cast<complexity::Model>(m), s.points);
+                const bool shape = m != complexity::PowerN && m != complexity::PowerM;
+                if (shape && s.fits[m].valid && (s.best < 0 || s.fits[m].rms_log < best_rms)) {
+                    s.best = m;
+                    best_rms = s.fits[m].rms_log;
+                }
+            }
+            double min_n = 0, max_n = 0;
+            for (const auto& p : s.points) {
+                min_n = min_n == 0 ? p.n : std::min(min_n, p.n);
+                max_n = std::max(max_n, p.n);
+            }
+            for (int m = 0; m < complexity::ModelCount; ++m) {
+                const complexity::Fit& f = s.fits[m];
+                if (!f.valid) continue;
+                const bool power = m == complexity::PowerN || m == complexity::PowerM;
+                std::ostringstream line;
+                line.setf(std::ios::fixed);
+                line << s.experiment << "\t" << s.algorithm << "\t" << complexity::model_name(m) << "\t" << f.points
+                     << "\t" << std::setprecision(0) << min_n << "\t" << max_n << "\t";
+                if (power) line << std::setprecision(3) << f.exponent;
+                line << "\t";
+                if (!power) line << std::setprecision(4) << f.coefficient * 1e6;
+                line << "\t" << std::setprecision(1) << (std::exp(f.rms_log) - 1) * 100
+                     << "\t" << std::setprecision(4) << f.r2 << "\t" << (m == s.best ? 1 : 0) << "\n";
+                out << line.str();
+            }
+        }
+
+        out << "\nExperiment\tAlgorithmA\tModelA\tAlgorithmB\tModelB\tFasterAtMaxN\tCrossover_n\tFasterBeyond\n";
+        for (size_t i = 0; i < series.size(); ++i) {
+            for (size_t j = i + 1; j < series.size(); ++j) {
+                const Series& a = series[i];
+                const Series& b = series[j];
+                if (a.experiment != b.experiment) continue;
+                std::vector<complexity::Point> both = a.points;
+                both.insert(both.end(), b.points.begin(), b.points.end());
+                const complexity::Growth growth = complexity::edge_growth(both);
+                double max_n = 0;
+                for (const auto& p : both) max_n = std::max(max_n, p.n);
+
+                const auto candidates = [](const Series& s) {
+                    std::vector<int> models{complexity::PowerN};
+                    if (s.algorithm == "bmssp") models.push_back(complexity::MLog23N);
+                    return models;
+                };
+                for (const int ma : candidates(a)) {
+                    for (const int mb : candidates(b)) {
+                        const complexity::Fit& fa = a.fits[ma];
+                        const complexity::Fit& fb = b.fits[mb];
+                        if (!fa.valid || !fb.valid) continue;
+                        const double m_at_max = growth.k * std::pow(max_n, growth.e);
+                        const bool a_faster = complexity::predict(fa, max_n, m_at_max) < complexity::predict(fb, max_n, m_at_max);
+                        const double cross = complexity::crossover(fa, fb, growth, max_n);
+                        out << a.experiment << "\t" << a.algorithm << "\t" << complexity::model_name(ma)
+                            << "\t" << b.algorithm << "\t" << complexity::model_name(mb)
+                            << "\t" << (a_faster ? a.algorithm : b.algorithm) << "\t";
+                        if (cross > 0) {
+                            std::ostringstream n_text;
+                            n_text.precision(3);
+                            n_text << cross;
+                            out << n_text.str() << "\t" << (a_faster ? b.algorithm : a.algorithm);
+                        } else {
+                            out << "\t";
+                        }
+                        out << "\n";
+                    }
+                }
+            }
+        }
+    }
+} // namespace results
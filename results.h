@@ -0,0 +1,78 @@
+#ifndef SMALLCPPPROGRAM_RESULTS_H
+#define SMALLCPPPROGRAM_RESULTS_H
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+
+// Machine-readable benchmark results (JSON, CSV) and comparison of two runs.
+namespace results {
+
+// Ordered key/value description of where a run happened: host, CPU, compiler, git commit.
+using Environment = std::vector<std::pair<std::string, std::string>>;
+
+Environment collect_environment(const std::string& config_file);
+
+// One (experiment, graph, algorithm) result, the same data as a row of the TSV.
+struct Row {
+    std::string experiment;
+    std::string generator;
+    std::string graph;
+    std::string algorithm;
+    long long edges = 0;
+    int cpu = -1;
+    std::string governor;
+    std::string valid; // Valid column, empty when not validated
+    std::string status; // ok, error, or how an isolated run ended (timeout, oom, killed, crashed, skipped); empty is derived from success
+    BenchmarkResult result{};
+};
+
+// Everything except the samples goes into the CSV; samples_ms is a JSON array.
+void write_json(std::ostream& out, const Environment& env, const std::vector<Row>& rows);
+void write_csv(std::ostream& out, const Environment& env, const std::vector<Row>& rows);
+
+// Rows and environment of a write_json file; throws std::runtime_error on malformed input.
+std::vector<Row> load_json(const std::string& path, Environment* env = nullptr);
+
+// One row as a single-line JSON object and back, as write_json/load_json store it.
+std::string to_json(const Row& row);
+Row row_from_json(const std::string& text);
+
+// One "# key differs" line per environment field that changed since the baseline (the timestamp aside).
+void report_environment_changes(const Environment& baseline, const Environment& current, std::ostream& report);
+
+struct CompareOptions {
+    double threshold = 0.05; // relative change of the median that counts as a slowdown or speed-up
+    double alpha = 0.01;     // significance level of the Mann-Whitney test
+};
+
+/**
+ * @brief Matches rows by experiment, graph, vertex count and algorithm and reports
+ * every change of the median, as TSV to `report`.
+ *
+ * A change counts when it exceeds the threshold and is significant: a Mann-Whitney
+ * test on the raw samples when both runs have at least three, otherwise 95%
+ * intervals of the median that do not overlap. Returns the number of regressions.
+ */
+int compare(const std::vector<Row>& baseline, const std::vector<Row>& current,
+            const CompareOptions& options, std::ostream& report);
+
+/**
+ * @brief Fits the growth models of complexity.h to each experiment's algorithms and
+ * writes two TSV tables to `out`, separated by a blank line.
+ *
+ * The first has one row per (experiment, algorithm, model) with the fitted exponent
+ * or coefficient and the residuals; Best marks the fixed shape that fits closest.
+ * The second extrapolates where each pair of algorithms swaps order, from the
+ * largest measured graph up to 1e15 vertices. It compares the empirical n^b fits,
+ * plus bmssp's m*log(n)^(2/3) bound against the others. Fits use median times of
+ * successful rows.
+ */
+void write_complexity(std::ostream& out, const std::vector<Row>& rows);
+
+} // namespace results
+
+#endif //SMALLCPPPROGRAM_RESULTS_H
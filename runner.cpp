@@ -0,0 +1,191 @@
+#include "runner.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include "parallel.h"
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace runner {
+    namespace {
+        const std::string cpu_dir = "/sys/devices/system/cpu/cpu";
+
+        int read_int(const std::string& path, const int fallback) {
+            std::ifstream in(path);
+            int value;
+            return in >> value ? value : fallback;
+        }
+
+        // The nodeN link sysfs puts in a CPU's directory on NUMA kernels.
+        int node_of(const int cpu) {
+            std::error_code ec;
+            for (const auto& entry : std::filesystem::directory_iterator(cpu_dir + std::to_string(cpu), ec)) {
+                const std::string name = entry.path().filename().string();
+                if (name.size() > 4 && name.rfind("node", 0) == 0 &&
+                    std::all_of(name.begin() + 4, name.end(), [](const char c) { return c >= '0' && c <= '9'; })) {
+                    return std::stoi(name.substr(4));
+                }
+            }
+            return 0;
+        }
+    } // namespace
+
+    std::vector<Cpu> usable_cpus() {
+        std::vector<int> ids;
+#if defined(__linux__)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; ++c) {
+                if (CPU_ISSET(c, &mask)) ids.push_back(c);
+            }
+        }
+#endif
+        if (ids.empty()) {
+            for (int c = 0; c < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++c) ids.push_back(c);
+        }
+
+        std::vector<Cpu> cpus;
+        for (const int id : ids) {
+            const std::string topology = cpu_dir + std::to_string(id) + "/topology/";
+            Cpu cpu;
+            cpu.id = id;
+            cpu.core = read_int(topology + "core_id", id);
+            cpu.package = read_int(topology + "physical_package_id", 0);
+            cpu.node = node_of(id);
+            cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    bool pin_current_thread(const int cpu) {
+#if defined(__linux__)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+        return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    bool prefer_node(const int node) {
+#if defined(__linux__)
+        unsigned long mask[16] = {};
+        constexpr unsigned long bits = 8 * sizeof(unsigned long);
+        if (node < 0 || static_cast<unsigned long>(node) >= bits * std::size(mask)) return false;
+        mask[node / bits] = 1UL << (node % bits);
+        return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, bits * std::size(mask)) == 0;
+#else
+        (void)node;
+        return false;
+#endif
+    }
+
+    int current_cpu() {
+#if defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    std::string governor(const int cpu) {
+        if (cpu < 0) return "";
+        std::ifstream in(cpu_dir + std::to_string(cpu) + "/cpufreq/scaling_governor");
+        std::string name;
+        in >> name;
+        return name;
+    }
+
+    Scheduler::Scheduler(const Options& options) {
+        const std::vector<Cpu> all = usable_cpus();
+        std::set<int> nodes;
+        for (const Cpu& cpu : all) nodes.insert(cpu.node);
+        nodes_ = static_cast<int>(nodes.size());
+
+        const bool pin = options.pin || options.physical_cores || options.numa_local;
+        std::vector<Cpu> candidates;
+        if (options.physical_cores) {
+            // lowest-numbered hardware thread of each core; the siblings get no worker
+            std::set<std::pair<int, int>> seen;
+            for (const Cpu& cpu : all) {
+                if (seen.insert({cpu.package, cpu.core}).second) candidates.push_back(cpu);
+            }
+        } else {
+            candidates = all;
+        }
+
+        width_ = options.jobs > 0 ? options.jobs : static_cast<int>(candidates.size());
+        if (pin) {
+            width_ = std::min(width_, static_cast<int>(candidates.size()));
+            cpus_.assign(candidates.begin(), candidates.begin() + width_);
+        }
+        width_ = std::max(width_, 1);
+        numa_local_ = options.numa_local;
+    }
+
+    void Scheduler::run(const size_t count, const std::function<bool(size_t)>& exclusive,
+                        const std::function<void(size_t, const Slot&)>& job) const {
+        if (width_ == 1 && cpus_.empty()) {
+            for (size_t i = 0; i < count; ++i) job(i, Slot{});
+            return;
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t next = 0;
+        int running = 0;
+        bool exclusive_running = false;
+
+        const auto worker = [&](const int w) {
+            Slot slot;
+            slot.worker = w;
+            if (!cpus_.empty() && pin_current_thread(cpus_[w].id)) {
+                slot.cpu = cpus_[w].id;
+                if (numa_local_ && prefer_node(cpus_[w].node)) slot.node = cpus_[w].node;
+            }
+            std::optional<parallel::InlineScope> inline_pool;
+            if (width_ > 1) inline_pool.emplace();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&] {
+                    if (next == count) return true;
+                    return exclusive(next) ? running == 0 : !exclusive_running;
+                });
+                if (next == count) return;
+                const size_t i = next++;
+                const bool alone = exclusive(i);
+                ++running;
+                exclusive_running = alone;
+                changed.notify_all(); // the job after this one may be startable too
+                lock.unlock();
+                job(i, slot);
+                lock.lock();
+                --running;
+                if (alone) exclusive_running = false;
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < width_; ++w) workers.emplace_back(worker, w);
+        for (auto& t : workers) t.join();
+    }
+} // namespace runner
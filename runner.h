@@ -0,0 +1,75 @@
+#ifndef SMALLCPPPROGRAM_RUNNER_H
+#define SMALLCPPPROGRAM_RUNNER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "runner_options.h"
+
+namespace runner {
+
+// A logical CPU this process may run on.
+struct Cpu {
+    int id = 0;
+    int core = 0;    // physical core within the package
+    int package = 0;
+    int node = 0;    // NUMA node
+};
+
+// CPUs of the process affinity mask with their sysfs topology; one entry per hardware thread.
+std::vector<Cpu> usable_cpus();
+
+bool pin_current_thread(int cpu);
+
+// Makes the calling thread's allocations prefer `node` (set_mempolicy MPOL_PREFERRED).
+bool prefer_node(int node);
+
+// CPU the calling thread is on now, -1 when unknown.
+int current_cpu();
+
+// cpufreq scaling governor of `cpu`, empty without cpufreq.
+std::string governor(int cpu);
+
+// Where a job runs: the worker's index, and its CPU and NUMA node when pinned (-1 otherwise).
+struct Slot {
+    int worker = 0;
+    int cpu = -1;
+    int node = -1;
+};
+
+/**
+ * @brief Runs numbered jobs on a set of workers, optionally pinned one per CPU.
+ *
+ * Jobs are started in index order. An exclusive job waits until the running ones
+ * finish and nothing else starts until it is done, for measurements that are
+ * process-wide (memory accounting, trace files). Workers of a run wider than one
+ * job keep parallel::default_pool() work on their own thread. With one unpinned
+ * worker the jobs run on the calling thread.
+ */
+class Scheduler {
+public:
+    explicit Scheduler(const Options& options);
+
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] bool pinned() const { return !cpus_.empty(); }
+    [[nodiscard]] int numa_nodes() const { return nodes_; }
+
+    // CPUs the workers are bound to, worker i on cpus()[i]; empty when unpinned.
+    [[nodiscard]] const std::vector<Cpu>& cpus() const { return cpus_; }
+
+    // Calls job(i, slot) for every i in [0, count) and returns when all are done; jobs must not throw.
+    void run(size_t count, const std::function<bool(size_t)>& exclusive,
+             const std::function<void(size_t, const Slot&)>& job) const;
+
+private:
+    int width_ = 1;
+    int nodes_ = 1;
+    bool numa_local_ = false;
+    std::vector<Cpu> cpus_;
+};
+
+} // namespace runner
+
+#endif //SMALLCPPPROGRAM_RUNNER_H
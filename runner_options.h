@@ -0,0 +1,16 @@
+#ifndef SMALLCPPPROGRAM_RUNNER_OPTIONS_H
+#define SMALLCPPPROGRAM_RUNNER_OPTIONS_H
+
+namespace runner {
+
+// How the benchmark spreads its (graph, algorithm) jobs; the defaults run them one after another, unpinned.
+struct Options {
+    int jobs = 1;                // concurrent jobs, 0 is one per usable CPU
+    bool pin = false;            // bind every worker to a CPU of its own
+    bool physical_cores = false; // at most one worker per physical core, its SMT siblings left idle (implies pin)
+    bool numa_local = false;     // workers allocate on their CPU's NUMA node and use a graph copy made there (implies pin)
+};
+
+} // namespace runner
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef SMALLCPPPROGRAM_SAMPLE_STATS_H
+#define SMALLCPPPROGRAM_SAMPLE_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Summaries of repeated timing samples that hold up with few iterations and noisy machines.
+namespace sample_stats {
+
+// Quantile q in [0, 1] of sorted samples, interpolating linearly between ranks.
+inline double quantile(const std::vector<double>& sorted, const double q) {
+    if (sorted.empty()) return 0.0;
+    const double pos = q * static_cast<double>(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (pos - static_cast<double>(lo)) * (sorted[hi] - sorted[lo]);
+}
+
+inline double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return quantile(samples, 0.5);
+}
+
+/**
+ * @brief Flags samples whose modified z-score exceeds the threshold.
+ *
+ * The score is 0.6745 * |x - median| / MAD (Iglewicz and Hoaglin); 3.5 is their
+ * recommended cut-off. When more than half the samples are equal the MAD is 0 and
+ * nothing is flagged.
+ */
+inline std::vector<bool> mad_outliers(const std::vector<double>& samples, const double threshold = 3.5) {
+    std::vector<bool> outlier(samples.size(), false);
+    if (samples.size() < 3) return outlier;
+    const double med = median(samples);
+    std::vector<double> deviation(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) deviation[i] = std::abs(samples[i] - med);
+    const double mad = median(deviation);
+    if (mad <= 0.0) return outlier;
+    for (size_t i = 0; i < samples.size(); ++i) outlier[i] = 0.6745 * deviation[i] / mad > threshold;
+    return outlier;
+}
+
+/**
+ * @brief mad_outliers within each of `groups` interleaved groups: sample i belongs to
+ * group i % groups.
+ *
+ * Pooled samples of a multi-source run differ systematically by source, so a pooled
+ * MAD flags whole sources and hides the outliers within one.
+ */
+inline std::vector<bool> mad_outliers_per_group(const std::vector<double>& samples, const size_t groups,
+                                                const double threshold = 3.5) {
+    if (groups <= 1) return mad_outliers(samples, threshold);
+    std::vector<bool> outlier(samples.size(), false);
+    std::vector<double> group;
+    for (size_t g = 0; g < groups; ++g) {
+        group.clear();
+        for (size_t i = g; i < samples.size(); i += groups) group.push_back(samples[i]);
+        const std::vector<bool> flagged = mad_outliers(group, threshold);
+        for (size_t j = 0; j < flagged.size(); ++j) outlier[g + j * groups] = flagged[j];
+    }
+    return outlier;
+}
+
+/**
+ * @brief Percentile bootstrap confidence interval of the median.
+ *
+ * The generator is seeded with a constant, so the same samples always give the same
+ * interval.
+ */
+inline std::pair<double, double> bootstrap_median_ci(const std::vector<double>& samples,
+                                                     const double confidence = 0.95,
+                                                     const int resamples = 1000) {
+    if (samples.empty()) return {0.0, 0.0};
+    if (samples.size() == 1) return {samples.front(), samples.front()};
+
+    std::mt19937_64 rng(0x5eed);
+    std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+    std::vector<double> resample(samples.size()), medians(resamples);
+    for (int r = 0; r < resamples; ++r) {
+        for (double& x : resample) x = samples[pick(rng)];
+        const auto mid = resample.begin() + resample.size() / 2;
+        std::nth_element(resample.begin(), mid, resample.end());
+        double m = *mid;
+        if (resample.size() % 2 == 0) m = (m + *std::max_element(resample.begin(), mid)) / 2;
+        medians[r] = m;
+    }
+    std::sort(medians.begin(), medians.end());
+    const double tail = (1.0 - confidence) / 2;
+    return {quantile(medians, tail), quantile(medians, 1.0 - tail)};
+}
+
+/**
+ * @brief Two-sided p-value of the Mann-Whitney U test that a and b share a distribution.
+ *
+ * Uses the normal approximation with tie and continuity corrections, which is
+ * reasonable from about five samples per side. Returns 1 when either side is empty
+ * or every sample is tied.
+ */
+inline double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    const size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    if (n1 == 0 || n2 == 0) return 1.0;
+    std::vector<std::pair<double, bool>> all; // value, from a
+    all.reserve(n);
+    for (const double x : a) all.emplace_back(x, true);
+    for (const double x : b) all.emplace_back(x, false);
+    std::sort(all.begin(), all.end());
+
+    double rank_sum_a = 0.0, tie_term = 0.0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].first == all[i].first) ++j;
+        const double rank = (static_cast<double>(i + j) + 1.0) / 2; // average of ranks i+1 .. j
+        for (size_t k = i; k < j; ++k) {
+            if (all[k].second) rank_sum_a += rank;
+        }
+        const double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    const double u = rank_sum_a - static_cast<double>(n1) * static_cast<double>(n1 + 1) / 2;
+    const double mean = static_cast<double>(n1) * static_cast<double>(n2) / 2;
+    const double nn = static_cast<double>(n);
+    const double variance = static_cast<double>(n1) * static_cast<double>(n2) / 12 *
+                            ((nn + 1) - tie_term / (nn * (nn - 1)));
+    if (variance <= 0.0) return 1.0;
+    const double z = std::max(0.0, std::abs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+} // namespace sample_stats
+
+#endif //SMALLCPPPROGRAM_SAMPLE_STATS_H
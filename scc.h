@@ -0,0 +1,183 @@
+#ifndef SMALLCPPPROGRAM_SCC_H
+#define SMALLCPPPROGRAM_SCC_H
+
+#include "graph_types.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Condensation of the part of the graph reachable from a source.
+ *
+ * Components are numbered in the order Tarjan's algorithm closes them, which is a
+ * reverse topological order: every edge leaving component c enters a component
+ * with a smaller id. Vertices unreachable from the source get component -1.
+ */
+struct SccCondensation {
+    std::vector<int> component;
+    std::vector<int> comp_start;   // offsets into vertices, size count + 1
+    std::vector<int> vertices;     // reachable vertices grouped by component
+    std::vector<char> trivial;     // single vertex without a self-loop
+    int count = 0;
+};
+
+// Iterative Tarjan, so deep paths and trees do not overflow the native stack.
+inline SccCondensation tarjan_scc(const Graph& graph, const int start)
+{
+    const int n = graph.size();
+    SccCondensation cond;
+    cond.component.assign(n, -1);
+    cond.comp_start.push_back(0);
+    if (n == 0) return cond;
+
+    std::vector<int> index(n, -1);
+    std::vector<int> low(n, 0);
+    std::vector<char> on_stack(n, 0);
+    std::vector<int> scc_stack;
+    std::vector<std::pair<int, size_t>> call_stack; // vertex, next edge to scan
+    int counter = 0;
+
+    index[start] = low[start] = counter++;
+    scc_stack.push_back(start);
+    on_stack[start] = 1;
+    call_stack.emplace_back(start, 0);
+
+    while (!call_stack.empty()) {
+        const int u = call_stack.back().first;
+        const size_t i = call_stack.back().second;
+
+        if (i < graph.adj[u].size()) {
+            call_stack.back().second++;
+            const int v = graph.adj[u][i].to;
+            if (index[v] == -1) {
+                index[v] = low[v] = counter++;
+                scc_stack.push_back(v);
+                on_stack[v] = 1;
+                call_stack.emplace_back(v, 0);
+            } else if (on_stack[v]) {
+                low[u] = std::min(low[u], index[v]);
+            }
+            continue;
+        }
+
+        call_stack.pop_back();
+        if (!call_stack.empty()) {
+            const int parent = call_stack.back().first;
+            low[parent] = std::min(low[parent], low[u]);
+        }
+        if (low[u] != index[u]) continue;
+
+        const int comp = cond.count++;
+        int v;
+        do {
+            v = scc_stack.back();
+            scc_stack.pop_back();
+            on_stack[v] = 0;
+            cond.component[v] = comp;
+            cond.vertices.push_back(v);
+        } while (v != u);
+        cond.comp_start.push_back(static_cast<int>(cond.vertices.size()));
+
+        bool single = cond.comp_start[comp + 1] - cond.comp_start[comp] == 1;
+        if (single) {
+            for (const auto& edge : graph.adj[u]) {
+                if (edge.to == u) {
+                    single = false;
+                    break;
+                }
+            }
+        }
+        cond.trivial.push_back(single ? 1 : 0);
+    }
+    return cond;
+}
+
+enum class SccInnerSolver {
+    Dijkstra,
+    BellmanFord
+};
+
+/**
+ * @brief SSSP over the condensation of the reachable subgraph.
+ *
+ * Components are processed in topological order. A trivial component's distance is
+ * final once its predecessors are done, so it only relaxes its out-edges; the inner
+ * solver runs only inside non-trivial components, seeded with the distances that
+ * arrived from earlier components. On a DAG this is a single O(n + m) pass.
+ */
+inline std::vector<double> scc_sssp(const Graph& graph, const int start, const SccInnerSolver inner)
+{
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    const int n = graph.size();
+    std::vector<double> dist(n, INF);
+
+    if (n == 0) return dist;
+
+    const SccCondensation cond = tarjan_scc(graph, start);
+    dist[start] = 0;
+
+    // shared by the components, which each drain it, so its buffer is reused
+    using QueueElement = std::pair<double, int>;
+    std::priority_queue<QueueElement, std::vector<QueueElement>, std::greater<>> pq;
+
+    for (int c = cond.count - 1; c >= 0; --c) {
+        const int* first = cond.vertices.data() + cond.comp_start[c];
+        const int* last = cond.vertices.data() + cond.comp_start[c + 1];
+
+        if (!cond.trivial[c]) {
+            if (inner == SccInnerSolver::Dijkstra) {
+                for (const int* it = first; it != last; ++it) {
+                    if (dist[*it] != INF) pq.emplace(dist[*it], *it);
+                }
+                while (!pq.empty()) {
+                    const double d = pq.top().first;
+                    const int u = pq.top().second;
+                    pq.pop();
+                    if (d > dist[u]) continue;
+                    for (const auto& edge : graph.adj[u]) {
+                        const int v = edge.to;
+                        if (cond.component[v] == c && dist[u] + edge.weight < dist[v]) {
+                            dist[v] = dist[u] + edge.weight;
+                            pq.emplace(dist[v], v);
+                        }
+                    }
+                }
+            } else {
+                const long long size = last - first;
+                for (long long round = 0; round < size - 1; ++round) {
+                    bool updated = false;
+                    for (const int* it = first; it != last; ++it) {
+                        const int u = *it;
+                        if (dist[u] == INF) continue;
+                        for (const auto& edge : graph.adj[u]) {
+                            const int v = edge.to;
+                            if (cond.component[v] == c && dist[u] + edge.weight < dist[v]) {
+                                dist[v] = dist[u] + edge.weight;
+                                updated = true;
+                            }
+                        }
+                    }
+                    if (!updated) break;
+                }
+            }
+        }
+
+        // Edges into later components: their targets are settled when their turn comes.
+        for (const int* it = first; it != last; ++it) {
+            const int u = *it;
+            if (dist[u] == INF) continue;
+            for (const auto& edge : graph.adj[u]) {
+                const int v = edge.to;
+                if (cond.component[v] != c && dist[u] + edge.weight < dist[v]) {
+                    dist[v] = dist[u] + edge.weight;
+                }
+            }
+        }
+    }
+    return dist;
+}
+
+#endif //SMALLCPPPROGRAM_SCC_H
@@ -0,0 +1,194 @@
+#ifndef SMALLCPPPROGRAM_SELECTION_H
+#define SMALLCPPPROGRAM_SELECTION_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// k-th element selection for BlockingBasedHeap (pull, split and batchPrepend), with
+// the alternatives measured by microbench/select_bench.cpp.
+
+enum floyd_rivest_constants {
+  kQCap = 600,
+};
+
+template <class Compare>
+struct CompareRefType {
+  // Pass the comparator by lvalue reference. Or in debug mode, using a
+  // debugging wrapper that stores a reference.
+  using type = typename std::add_lvalue_reference<Compare>::type;
+};
+
+template <class Iter, class Compare,
+          class DiffType = typename std::iterator_traits<Iter>::difference_type,
+          long QCap = floyd_rivest_constants::kQCap>
+inline void floyd_rivest_select_loop(Iter begin, DiffType left, DiffType right,
+                                     DiffType k, Compare comp) {
+  while (right > left) {
+    DiffType size = right - left;
+    if (size > QCap) {
+      DiffType n = right - left + 1;
+      DiffType i = k - left + 1;
+
+      double z = log(n);
+      double s = 0.5 * exp(2 * z / 3);
+      double sd = 0.5 * sqrt(z * s * (n - s) / n);
+      if (i < n / 2) {
+        sd *= -1.0;
+      }
+      DiffType new_left =
+          std::max(left, static_cast<DiffType>(k - i * s / n + sd));
+      DiffType new_right =
+          std::min(right, static_cast<DiffType>(k + (n - i) * s / n + sd));
+      floyd_rivest_select_loop<Iter, Compare, DiffType, QCap>(begin, new_left,
+                                                              new_right, k, comp);
+    }
+    DiffType i = left;
+    DiffType j = right;
+
+    std::swap(begin[left], begin[k]);
+    const bool to_swap = comp(begin[left], begin[right]);
+    if (to_swap) {
+      std::swap(begin[left], begin[right]);
+    }
+    // Make sure that non copyable types compile.
+    const auto& t = to_swap ? begin[left] : begin[right];
+    while (i < j) {
+      std::swap(begin[i], begin[j]);
+      i++;
+      j--;
+      while (comp(begin[i], t)) {
+        i++;
+      }
+      while (comp(t, begin[j])) {
+        j--;
+      }
+    }
+
+    if (to_swap) {
+      std::swap(begin[left], begin[j]);
+    } else {
+      j++;
+      std::swap(begin[right], begin[j]);
+    }
+
+    if (j <= k) {
+      left = j + 1;
+    }
+    if (k <= j) {
+      right = j - 1;
+    }
+  }
+}
+
+template <class Iter, class Compare>
+inline void floyd_rivest_partial_sort(Iter begin, Iter mid, Iter end,
+                                      Compare comp) {
+  if (begin == end) return;
+  if (begin == mid) return;
+  using CompType = CompareRefType<Compare>::type;
+  using DiffType = std::iterator_traits<Iter>::difference_type;
+  floyd_rivest_select_loop<Iter, CompType>(
+      begin, DiffType{0}, static_cast<DiffType>(end - begin - 1),
+      static_cast<DiffType>(mid - begin - 1), comp);
+  // std::sort proved to be better than other sorts because of pivoting.
+  std::sort<Iter, CompType>(begin, mid, comp);
+}
+
+template <class Iter>
+inline void floyd_rivest_partial_sort(Iter begin, Iter mid, Iter end) {
+  typedef typename std::iterator_traits<Iter>::value_type T;
+  floyd_rivest_partial_sort(begin, mid, end, std::less<T>());
+}
+
+template <class Iter, class Compare, long QCap = floyd_rivest_constants::kQCap>
+inline void floyd_rivest_select(Iter begin, Iter mid, Iter end, Compare comp) {
+  if (mid == end) return;
+  using CompType = CompareRefType<Compare>::type;
+  using DiffType = std::iterator_traits<Iter>::difference_type;
+  floyd_rivest_select_loop<Iter, CompType, DiffType, QCap>(
+      begin, DiffType{0}, static_cast<DiffType>(end - begin - 1),
+      static_cast<DiffType>(mid - begin), comp);
+}
+
+template <class Iter>
+inline void floyd_rivest_select(Iter begin, Iter mid, Iter end) {
+  typedef typename std::iterator_traits<Iter>::value_type T;
+  floyd_rivest_select(begin, mid, end, std::less<T>());
+}
+
+// Lomuto partition around *first without a data-dependent branch: every element is
+// swapped to the boundary and the boundary advances by the comparison result.
+// Returns the final position of the pivot.
+template <class Iter, class Compare>
+inline Iter branchless_lomuto_partition(Iter first, Iter last, Compare comp) {
+  const auto pivot = *first;
+  Iter store = first + 1;
+  for (Iter it = first + 1; it != last; ++it) {
+    const bool less = comp(*it, pivot);
+    std::iter_swap(store, it);
+    store += less;
+  }
+  --store;
+  std::iter_swap(first, store);
+  return store;
+}
+
+// Quickselect with a median-of-three pivot over the branchless partition. Short ranges
+// finish with insertion sort; a bad pivot streak falls back to std::nth_element.
+template <class Iter, class Compare>
+inline void branchless_select(Iter first, Iter nth, Iter last, Compare comp) {
+  if (nth == last) return;
+  int budget = 2 * std::bit_width(static_cast<size_t>(last - first));
+  while (last - first > 16) {
+    if (budget-- == 0) {
+      std::nth_element(first, nth, last, comp);
+      return;
+    }
+    Iter mid = first + (last - first) / 2;
+    if (comp(*mid, *first)) std::iter_swap(mid, first);
+    if (comp(*(last - 1), *mid)) {
+      std::iter_swap(last - 1, mid);
+      if (comp(*mid, *first)) std::iter_swap(mid, first);
+    }
+    std::iter_swap(first, mid);
+    Iter p = branchless_lomuto_partition(first, last, comp);
+    if (p == nth) return;
+    if (nth < p) last = p;
+    else first = p + 1;
+  }
+  for (Iter i = first + 1; i < last; ++i) {
+    for (Iter j = i; j != first && comp(*j, *(j - 1)); --j) std::iter_swap(j, j - 1);
+  }
+}
+
+enum class SelectStrategy {
+  FloydRivest,
+  NthElement,
+  Branchless,
+};
+
+// Build with -DBMSSP_SELECT_STRATEGY=<n> (0 Floyd-Rivest, 1 nth_element, 2 branchless)
+#ifndef BMSSP_SELECT_STRATEGY
+#define BMSSP_SELECT_STRATEGY 0
+#endif
+inline constexpr SelectStrategy kSelectStrategy = static_cast<SelectStrategy>(BMSSP_SELECT_STRATEGY);
+
+// Puts the element of rank nth - first at nth, smaller ones before it, larger after.
+template <SelectStrategy Strategy = kSelectStrategy, class Iter, class Compare>
+inline void select_nth(Iter first, Iter nth, Iter last, Compare comp) {
+  if constexpr (Strategy == SelectStrategy::FloydRivest) {
+    floyd_rivest_select(first, nth, last, comp);
+  } else if constexpr (Strategy == SelectStrategy::NthElement) {
+    std::nth_element(first, nth, last, comp);
+  } else {
+    branchless_select(first, nth, last, comp);
+  }
+}
+
+#endif //SMALLCPPPROGRAM_SELECTION_H
@@ -118,6 +118,7 @@ private:
 
 template<> inline std::string Node::as<std::string>() const { return Scalar(); }
 template<> inline int Node::as<int>() const { return std::stoi(Scalar()); }
+template<> inline long long Node::as<long long>() const { return std::stoll(Scalar()); }
 template<> inline double Node::as<double>() const { return std::stod(Scalar()); }
 template<> inline bool Node::as<bool>() const {
     auto s = Scalar(); std::transform(s.begin(), s.end(), s.begin(), ::tolower);
@@ -0,0 +1,29 @@
+#ifndef SMALLCPPPROGRAM_TESTS_CHECK_H
+#define SMALLCPPPROGRAM_TESTS_CHECK_H
+
+#include <iostream>
+
+namespace check {
+
+inline int failures = 0;
+
+// Counts a failed condition and reports where it was; the test binary exits with the count.
+inline bool expect(const bool ok, const char* condition, const char* file, const int line) {
+    if (!ok) {
+        ++failures;
+        std::cerr << file << ":" << line << ": check failed: " << condition << "\n";
+    }
+    return ok;
+}
+
+inline int finish(const char* suite) {
+    if (failures == 0) std::cout << suite << ": all checks passed\n";
+    else std::cerr << suite << ": " << failures << " check(s) failed\n";
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace check
+
+#define CHECK(condition) ::check::expect(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif
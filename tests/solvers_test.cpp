@@ -0,0 +1,136 @@
+// Every solver against dijkstra() on generated graphs, from several sources, and the
+// three select_nth strategies against std::nth_element. Generated graphs are not
+// seeded, so a failure names the graph it happened on.
+
+#include <iostream>
+#include "dijkstra.h"
+#include "bmssp.h"
+#include "graph_generators.h"
+#include "scc.h"
+#include "selection.h"
+#include "validation.h"
+#include "tests/check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool same_distances(const std::span<const double> expected, const std::span<const double> actual) {
+    if (expected.size() != actual.size()) return false;
+    for (size_t v = 0; v < expected.size(); ++v) {
+        const double a = expected[v], b = actual[v];
+        if (std::isinf(a) || std::isinf(b)) {
+            if (a != b) return false;
+        } else if (std::abs(a - b) > 1e-9 * std::max(1.0, std::abs(a))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct NamedGraph {
+    std::string name;
+    Graph graph;
+};
+
+std::vector<NamedGraph> test_graphs() {
+    using namespace generators;
+    std::vector<NamedGraph> graphs;
+    for (const int n : {50, 300, 1500}) {
+        const std::string size = " n=" + std::to_string(n);
+        graphs.push_back({"random cycles" + size,
+                          gen_random_graph(n, 8.0 / n, 1, CycleType::PositiveCycles, ConnectivityType::StronglyConnected, true)});
+        graphs.push_back({"random acyclic" + size,
+                          gen_random_graph(n, 8.0 / n, 1, CycleType::Acyclic, ConnectivityType::WeaklyConnected, true)});
+        graphs.push_back({"tree" + size, gen_tree(n, true, 4)});
+        graphs.push_back({"path" + size, gen_path(n, true)});
+    }
+    graphs.push_back({"grid 40x40", gen_grid(40, 40, true)});
+    graphs.push_back({"undirected planar", gen_planar(500, 0.5, false)});
+    return graphs;
+}
+
+// bmssp with and without the constant-degree transformation, one solver per graph, so
+// later queries reuse the state the earlier ones left in the context.
+void check_solvers(const NamedGraph& named) {
+    const Graph& graph = named.graph;
+    const int n = graph.size();
+    bmssp<double> plain(graph), transformed(graph);
+    plain.prepare_graph(false);
+    transformed.prepare_graph(true);
+
+    for (const int s : {0, n / 2, n - 1}) {
+        const std::vector<double> expected = dijkstra(graph, s, "");
+        const std::string where = named.name + ", source " + std::to_string(s);
+        const auto report = [&](const char* solver, const bool ok) {
+            if (!CHECK(ok)) std::cerr << "  " << solver << " on " << where << "\n";
+        };
+
+        const validation::Violations found = validation::verify_distances(graph, s, expected, 1e-9);
+        report("dijkstra certificate", !found.bad_source && found.loose_edges == 0 && found.unsupported == 0);
+        report("bmssp", same_distances(expected, plain.query(s).dist));
+        report("bmssp constant-degree", same_distances(expected, transformed.query(s).dist));
+        report("scc_dijkstra", same_distances(expected, scc_sssp(graph, s, SccInnerSolver::Dijkstra)));
+        report("scc_bellman_ford", same_distances(expected, scc_sssp(graph, s, SccInnerSolver::BellmanFord)));
+    }
+}
+
+void check_scc() {
+    const Graph circle = generators::gen_circle(100, true);
+    const SccCondensation one = tarjan_scc(circle, 0);
+    CHECK(one.count == 1);
+    CHECK(one.vertices.size() == 100);
+
+    const Graph path = generators::gen_path(100, true);
+    const SccCondensation singles = tarjan_scc(path, 0);
+    CHECK(singles.count == 100);
+    CHECK(std::all_of(singles.trivial.begin(), singles.trivial.end(), [](const char t) { return t != 0; }));
+
+    // only what the start reaches is condensed
+    CHECK(tarjan_scc(path, 60).vertices.size() == 40);
+}
+
+template <SelectStrategy Strategy>
+void check_select(const char* strategy, std::mt19937_64& rng) {
+    for (const size_t n : {1, 2, 3, 7, 31, 100, 1000, 20000}) {
+        for (const int range : {4, 1 << 30}) { // many duplicates, then few
+            std::uniform_int_distribution<int> value(0, range);
+            std::vector<int> input(n);
+            for (int& x : input) x = value(rng);
+            std::vector<int> sorted_input = input;
+            std::sort(sorted_input.begin(), sorted_input.end());
+            for (const size_t k : {size_t{0}, n / 3, n / 2, n - 1}) {
+                std::vector<int> expected = input, actual = input;
+                std::nth_element(expected.begin(), expected.begin() + k, expected.end());
+                select_nth<Strategy>(actual.begin(), actual.begin() + k, actual.end(), std::less<>());
+                const int nth = actual[k];
+                bool ok = nth == expected[k]
+                    && std::all_of(actual.begin(), actual.begin() + k, [&](const int x) { return x <= nth; })
+                    && std::all_of(actual.begin() + k, actual.end(), [&](const int x) { return x >= nth; });
+                std::sort(actual.begin(), actual.end());
+                ok = ok && actual == sorted_input;
+                if (!CHECK(ok)) std::cerr << "  " << strategy << ", n=" << n << ", k=" << k << "\n";
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    for (const NamedGraph& named : test_graphs()) check_solvers(named);
+    check_scc();
+
+    std::mt19937_64 rng(12345);
+    check_select<SelectStrategy::FloydRivest>("floyd_rivest", rng);
+    check_select<SelectStrategy::NthElement>("nth_element", rng);
+    check_select<SelectStrategy::Branchless>("branchless", rng);
+    return check::finish("solvers_test");
+}
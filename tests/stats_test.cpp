@@ -0,0 +1,143 @@
+// The statistics behind the result columns: sample_stats, the growth-model fits, and a
+// results row through to_json and row_from_json.
+
+#include "complexity.h"
+#include "results.h"
+#include "sample_stats.h"
+#include "tests/check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool close(const double a, const double b, const double relative) {
+    return std::abs(a - b) <= relative * std::max(std::abs(a), std::abs(b));
+}
+
+void check_sample_stats() {
+    using namespace sample_stats;
+    CHECK(median({5, 1, 3}) == 3);
+    CHECK(median({4, 1, 3, 2}) == 2.5);
+    CHECK(quantile({0, 10, 20, 30, 40}, 0.9) == 36);
+
+    const std::vector<double> one_spike{10, 10.2, 9.9, 10.1, 9.8, 10, 30};
+    const std::vector<bool> flagged = mad_outliers(one_spike);
+    CHECK(flagged.back());
+    CHECK(std::count(flagged.begin(), flagged.end(), true) == 1);
+
+    // two interleaved sources, ten times apart, with a spike in the slow one: pooled, the
+    // spike hides in the spread between sources; per source it is the only outlier
+    std::vector<double> two_sources;
+    for (int i = 0; i < 8; ++i) {
+        two_sources.push_back(1.0 + 0.01 * (i % 3));
+        two_sources.push_back(i == 5 ? 14.0 : 10.0 + 0.1 * (i % 3));
+    }
+    const std::vector<bool> pooled = mad_outliers(two_sources);
+    const std::vector<bool> per_source = mad_outliers_per_group(two_sources, 2);
+    CHECK(!pooled[11]);
+    CHECK(per_source[11]);
+    CHECK(std::count(per_source.begin(), per_source.end(), true) == 1);
+
+    const auto [low, high] = bootstrap_median_ci(one_spike);
+    CHECK(low <= median(one_spike));
+    CHECK(median(one_spike) <= high);
+
+    CHECK(mann_whitney_p({1, 2, 3, 4, 5, 6, 7, 8}, {11, 12, 13, 14, 15, 16, 17, 18}) < 0.01);
+    CHECK(mann_whitney_p({1, 3, 5, 7, 9, 11}, {2, 4, 6, 8, 10, 12}) > 0.5);
+}
+
+void check_complexity() {
+    using namespace complexity;
+    std::vector<Point> points;
+    for (double n = 1000; n <= 1e6; n *= 2) points.push_back({n, 4 * n, 2e-6 * std::pow(n, 1.5)});
+
+    const Fit power = fit(PowerN, points);
+    CHECK(power.valid);
+    CHECK(close(power.exponent, 1.5, 1e-9));
+    CHECK(close(power.coefficient, 2e-6, 1e-6));
+    CHECK(power.r2 > 0.999999);
+    CHECK(close(predict(power, 4e6, 1.6e7), 2e-6 * std::pow(4e6, 1.5), 1e-6));
+
+    // time = m log n grows slower than n^1.5 here, and starts out above it
+    std::vector<Point> slower;
+    for (const Point& p : points) slower.push_back({p.n, p.m, 1e-3 * p.m * log_n(p.n)});
+    const Fit mlogn = fit(MLogN, slower);
+    CHECK(mlogn.valid);
+    CHECK(mlogn.rms_log < 1e-9);
+    const double cross = crossover(power, mlogn, edge_growth(points), 1000);
+    CHECK(cross > 1000);
+    CHECK(predict(power, cross * 2, 8 * cross) > predict(mlogn, cross * 2, 8 * cross));
+
+    CHECK(!fit(PowerN, {{1000, 4000, 1.0}}).valid); // one size gives no exponent
+}
+
+void check_results_round_trip() {
+    results::Row row;
+    row.experiment = "Grid \"quoted\"\tand tabbed";
+    row.generator = "grid";
+    row.graph = "grid [rows=10, cols=10]";
+    row.algorithm = "bmssp";
+    row.edges = 360;
+    row.cpu = 3;
+    row.governor = "performance";
+    row.valid = "ok";
+    row.status = "ok";
+    BenchmarkResult& res = row.result;
+    res.algorithm_name = "bmssp";
+    res.vertices = 100;
+    res.edges = 360;
+    res.success = true;
+    res.iterations = 4;
+    res.avg_time_ms = 1.25;
+    res.min_time_ms = 1;
+    res.max_time_ms = 1.5;
+    res.std_dev_ms = 0.125;
+    res.median_ms = 1.25;
+    res.phase_ms = {0.5, 0.25, 1, 0};
+    res.sources = 2;
+    res.qps = 800;
+    res.metrics = {{"recursion_ms", 0.75}};
+    res.samples_ms = {1, 1.5, 1.25, 1.25};
+    res.sample_sources = {0, 7, 0, 7};
+
+    const results::Row back = results::row_from_json(results::to_json(row));
+    CHECK(back.experiment == row.experiment);
+    CHECK(back.graph == row.graph);
+    CHECK(back.algorithm == row.algorithm);
+    CHECK(back.edges == row.edges);
+    CHECK(back.cpu == row.cpu);
+    CHECK(back.governor == row.governor);
+    CHECK(back.valid == row.valid);
+    CHECK(back.status == row.status);
+    CHECK(back.result.success);
+    CHECK(back.result.vertices == 100);
+    CHECK(back.result.iterations == 4);
+    CHECK(back.result.median_ms == 1.25);
+    CHECK(back.result.phase_ms == res.phase_ms);
+    CHECK(back.result.sources == 2);
+    CHECK(back.result.metrics == res.metrics);
+    CHECK(back.result.samples_ms == res.samples_ms);
+    CHECK(back.result.sample_sources == res.sample_sources);
+
+    results::Row failed;
+    failed.algorithm = "bellman_ford";
+    failed.status = "timeout";
+    failed.result.success = false;
+    failed.result.error_msg = "over 5 s";
+    const results::Row failed_back = results::row_from_json(results::to_json(failed));
+    CHECK(!failed_back.result.success);
+    CHECK(failed_back.status == "timeout");
+    CHECK(failed_back.result.error_msg == "over 5 s");
+}
+
+} // namespace
+
+int main() {
+    check_sample_stats();
+    check_complexity();
+    check_results_round_trip();
+    return check::finish("stats_test");
+}
@@ -0,0 +1,113 @@
+#ifndef SMALLCPPPROGRAM_VALIDATION_H
+#define SMALLCPPPROGRAM_VALIDATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "graph_types.h"
+
+// Cheap checks that solvers agree on a distance vector, run outside the timed region.
+namespace validation {
+
+/**
+ * @brief Order-independent summary of a distance vector.
+ *
+ * Counts are exact. The sums are compared with a relative tolerance, so solvers that
+ * add the same path weights in a different order still match. The weighted sum gives
+ * every vertex its own pseudo-random weight in [1, 2), so a distance reported at the
+ * wrong vertex changes it even when the plain sum stays the same.
+ */
+struct Checksum {
+    long long reachable = 0;    // finite distances
+    long long non_finite = 0;   // -inf or NaN, e.g. behind a negative cycle
+    long double sum = 0;
+    long double weighted = 0;
+    long double magnitude = 0;  // sum of |d|, the scale the tolerance applies to
+};
+
+inline double vertex_weight(const int v) {
+    uint64_t x = static_cast<uint64_t>(v) + 0x9e3779b97f4a7c15ULL; // splitmix64
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return 1.0 + static_cast<double>(x >> 11) * 0x1.0p-53;
+}
+
+template <typename Dist>
+Checksum checksum(const Dist& dist) {
+    Checksum c;
+    const int n = static_cast<int>(std::size(dist));
+    for (int v = 0; v < n; ++v) {
+        const double d = dist[v];
+        if (d == std::numeric_limits<double>::infinity()) continue;
+        if (!std::isfinite(d)) {
+            ++c.non_finite;
+            continue;
+        }
+        ++c.reachable;
+        c.sum += d;
+        c.weighted += static_cast<long double>(d) * vertex_weight(v);
+        c.magnitude += std::abs(d);
+    }
+    return c;
+}
+
+inline bool agree(const Checksum& a, const Checksum& b, const double tolerance) {
+    if (a.reachable != b.reachable || a.non_finite != b.non_finite) return false;
+    // the weighted sum is at most twice the magnitude, and both sides round independently
+    const long double slack = tolerance * (a.magnitude + b.magnitude) + std::numeric_limits<double>::min();
+    return std::abs(a.sum - b.sum) <= slack && std::abs(a.weighted - b.weighted) <= 2 * slack;
+}
+
+// What verify_distances found wrong; all zero is a valid shortest-path certificate.
+struct Violations {
+    long long loose_edges = 0; // d[v] > d[u] + w beyond the tolerance
+    long long unsupported = 0; // reachable vertices other than the source with no edge u->v where d[v] == d[u] + w
+    bool bad_source = false;   // d[source] is not 0
+
+    [[nodiscard]] long long total() const { return loose_edges + unsupported + (bad_source ? 1 : 0); }
+};
+
+/**
+ * @brief Checks dist against every edge of the graph in O(n + m).
+ *
+ * The triangle inequality alone holds for any underestimate (all zeros, say), so
+ * every reachable vertex must also have a tight incoming edge; together they prove
+ * dist is the shortest-path distance when the graph has no zero or negative cycles.
+ * Vertices with non-finite distances are skipped.
+ */
+template <typename Dist>
+Violations verify_distances(const Graph& graph, const int source, const Dist& dist, const double tolerance) {
+    Violations found;
+    const int n = graph.size();
+    if (source < 0 || source >= n) return found;
+    found.bad_source = dist[source] != 0.0;
+
+    std::vector<char> supported(n, 0);
+    for (int u = 0; u < n; ++u) {
+        const double du = dist[u];
+        if (!std::isfinite(du)) continue;
+        for (const Edge& e : graph.adj[u]) {
+            const double dv = dist[e.to];
+            if (std::isnan(dv) || dv == -std::numeric_limits<double>::infinity()) continue;
+            const double via = du + e.weight;
+            const double slack = tolerance * (std::abs(du) + std::abs(e.weight) + (std::isfinite(dv) ? std::abs(dv) : 0.0));
+            if (dv > via + slack) {
+                ++found.loose_edges;
+            } else if (std::abs(dv - via) <= slack) {
+                supported[e.to] = 1;
+            }
+        }
+    }
+    for (int v = 0; v < n; ++v) {
+        if (v != source && std::isfinite(dist[v]) && !supported[v]) ++found.unsupported;
+    }
+    return found;
+}
+
+} // namespace validation
+
+#endif //SMALLCPPPROGRAM_VALIDATION_H